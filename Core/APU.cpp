@@ -8,13 +8,17 @@
 #include "ApuFrameCounter.h"
 #include "EmulationSettings.h"
 #include "SoundMixer.h"
+#include "BaseExpansionAudio.h"
 #include "MemoryManager.h"
+#include "Profiler.h"
 
 APU::APU(shared_ptr<Console> console)
 {
 	_nesModel = NesModel::Auto;
 	_apuEnabled = true;
 	_needToRun = false;
+	_nextRunCycle = 0;
+	_expansionAudio = nullptr;
 
 	_console = console;
 	_mixer = _console->GetSoundMixer();
@@ -56,6 +60,7 @@ void APU::SetNesModel(NesModel model, bool forceInit)
 		_frameCounter->SetNesModel(model);
 
 		_mixer->SetNesModel(model);
+		_nextRunCycle = 0;
 	}
 }
 
@@ -126,6 +131,7 @@ void APU::WriteRAM(uint16_t addr, uint8_t value)
 	_triangleChannel->SetEnabled((value & 0x04) == 0x04);
 	_noiseChannel->SetEnabled((value & 0x08) == 0x08);
 	_deltaModulationChannel->SetEnabled((value & 0x10) == 0x10);
+	_nextRunCycle = 0;
 }
 
 void APU::GetMemoryRanges(MemoryRanges &ranges)
@@ -136,6 +142,8 @@ void APU::GetMemoryRanges(MemoryRanges &ranges)
 
 void APU::Run()
 {
+	PROFILE_SECTION(ProfilerSection::Apu);
+
 	//Update framecounter and all channels
 	//This is called:
 	//-At the end of a frame
@@ -159,18 +167,29 @@ void APU::Run()
 		_triangleChannel->Run(_previousCycle);
 		_deltaModulationChannel->Run(_previousCycle);
 	}
+
+	if(_expansionAudio) {
+		_expansionAudio->Run(_currentCycle);
+	}
 }
 
 void APU::SetNeedToRun()
 {
 	_needToRun = true;
+	_nextRunCycle = 0;
+}
+
+void APU::InvalidateNextRunCycle()
+{
+	//Called when a register write or DMA changes when the next event will occur
+	_nextRunCycle = 0;
 }
 
 bool APU::NeedToRun(uint32_t currentCycle)
 {
 	if(_deltaModulationChannel->NeedToRun() || _needToRun) {
 		//Need to run whenever we alter the length counters
-		//Need to run every cycle when DMC is running to get accurate emulation (CPU stalling, interaction with sprite DMA, etc.)
+		//Need to run when DMC is running to get accurate emulation (CPU stalling, interaction with sprite DMA, etc.)
 		_needToRun = false;
 		return true;
 	}
@@ -179,14 +198,22 @@ bool APU::NeedToRun(uint32_t currentCycle)
 	return _frameCounter->NeedToRun(cyclesToRun) || _deltaModulationChannel->IrqPending(cyclesToRun);
 }
 
+void APU::UpdateNextRunCycle()
+{
+	//Find the first cycle where NeedToRun can return true - all cycles before it can be skipped and run in a single batch later on
+	uint32_t cyclesToEvent = _needToRun ? 0 : std::min(_frameCounter->GetCyclesToNextEvent(), _deltaModulationChannel->GetCyclesToNextEvent());
+	cyclesToEvent = std::min<uint32_t>(cyclesToEvent, SoundMixer::CycleLength);
+	_nextRunCycle = std::min<uint32_t>(std::max(_previousCycle + cyclesToEvent, _currentCycle + 1), SoundMixer::CycleLength - 1);
+}
+
 void APU::Exec()
 {
-	_currentCycle++;
 	if(_currentCycle == SoundMixer::CycleLength - 1) {
 		EndFrame();
 	} else if(NeedToRun(_currentCycle)) {
 		Run();
 	}
+	UpdateNextRunCycle();
 }
 
 void APU::EndFrame()
@@ -197,25 +224,29 @@ void APU::EndFrame()
 	_triangleChannel->EndFrame();
 	_noiseChannel->EndFrame();
 	_deltaModulationChannel->EndFrame();
+	if(_expansionAudio) {
+		_expansionAudio->EndFrame();
+	}
 
 	_mixer->PlayAudioBuffer(_currentCycle);
 
 	_currentCycle = 0;
 	_previousCycle = 0;
+	_nextRunCycle = 0;
 }
 
-void APU::ProcessCpuClock()
+void APU::Reset(bool softReset)
 {
-	if(_apuEnabled) {
-		Exec();
+	if(_expansionAudio) {
+		//Bring the expansion audio up to date before the cycle counter is reset
+		_expansionAudio->Run(_currentCycle);
+		_expansionAudio->EndFrame();
 	}
-}
 
-void APU::Reset(bool softReset)
-{
 	_apuEnabled = true;
 	_currentCycle = 0;
 	_previousCycle = 0;
+	_nextRunCycle = 0;
 	_squareChannel[0]->Reset(softReset);
 	_squareChannel[1]->Reset(softReset);
 	_triangleChannel->Reset(softReset);
@@ -232,6 +263,7 @@ void APU::StreamState(bool saving)
 	} else {
 		_previousCycle = 0;
 		_currentCycle = 0;
+		_nextRunCycle = 0;
 	}
 
 	SnapshotInfo squareChannel0{ _squareChannel[0].get() };
@@ -249,6 +281,16 @@ void APU::AddExpansionAudioDelta(AudioChannel channel, int16_t delta)
 	_mixer->AddDelta(channel, _currentCycle, delta);
 }
 
+void APU::AddExpansionAudioDelta(AudioChannel channel, int16_t delta, uint32_t cycle)
+{
+	_mixer->AddDelta(channel, cycle, delta);
+}
+
+void APU::SetExpansionAudio(BaseExpansionAudio* audio)
+{
+	_expansionAudio = audio;
+}
+
 void APU::SetApuStatus(bool enabled)
 {
 	_apuEnabled = enabled;
@@ -12,6 +12,7 @@ class NoiseChannel;
 class DeltaModulationChannel;
 class ApuFrameCounter;
 class SoundMixer;
+class BaseExpansionAudio;
 enum class FrameType;
 enum class NesModel;
 
@@ -26,12 +27,18 @@ class APU : public Snapshotable, public IMemoryHandler
 		uint32_t _previousCycle;
 		uint32_t _currentCycle;
 
+		//Cycle at which the APU needs to check whether it has to run again (frame counter steps, DMC clocks & IRQs, end of frame)
+		uint32_t _nextRunCycle;
+
 		std::unique_ptr<SquareChannel> _squareChannel[2];
 		std::unique_ptr<TriangleChannel> _triangleChannel;
 		std::unique_ptr<NoiseChannel> _noiseChannel;
 		std::unique_ptr<DeltaModulationChannel> _deltaModulationChannel;
 		std::unique_ptr<ApuFrameCounter> _frameCounter;
 
+		//Expansion audio chip that generates its output in blocks (owned by the mapper)
+		BaseExpansionAudio* _expansionAudio;
+
 		std::shared_ptr<Console> _console;
 		std::shared_ptr<SoundMixer> _mixer;
 		EmulationSettings* _settings;
@@ -40,6 +47,8 @@ class APU : public Snapshotable, public IMemoryHandler
 
 	private:
 		__forceinline bool NeedToRun(uint32_t currentCycle);
+		void UpdateNextRunCycle();
+		void Exec();
 
 		void FrameCounterTick(FrameType type);
 		uint8_t GetStatus();
@@ -61,15 +70,28 @@ class APU : public Snapshotable, public IMemoryHandler
 
 		ApuState GetState();
 
-		void Exec();
-		void ProcessCpuClock();
+		__forceinline void ProcessCpuClock();
 		void Run();
 		void EndFrame();
 
 		void AddExpansionAudioDelta(AudioChannel channel, int16_t delta);
+		void AddExpansionAudioDelta(AudioChannel channel, int16_t delta, uint32_t cycle);
+		void SetExpansionAudio(BaseExpansionAudio* audio);
 		void SetApuStatus(bool enabled);
 		bool IsApuEnabled();
 		uint16_t GetDmcReadAddress();
 		void SetDmcReadBuffer(uint8_t value);
 		void SetNeedToRun();
+		void InvalidateNextRunCycle();
 };
+
+void APU::ProcessCpuClock()
+{
+	//Called on every CPU cycle - the APU only runs when the next scheduled event is reached or when its registers are accessed
+	if(_apuEnabled) {
+		_currentCycle++;
+		if(_currentCycle >= _nextRunCycle) {
+			Exec();
+		}
+	}
+}
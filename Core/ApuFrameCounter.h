@@ -167,6 +167,16 @@ public:
 		return _newValue >= 0 || _blockFrameCounterTick > 0 || (_previousCycle + (int32_t)cyclesToRun >= _stepCycles[_stepMode][_currentStep] - 1);
 	}
 
+	uint32_t GetCyclesToNextEvent()
+	{
+		//Smallest value of cyclesToRun for which NeedToRun returns true
+		if(_newValue >= 0 || _blockFrameCounterTick > 0) {
+			return 0;
+		}
+		int32_t cycles = _stepCycles[_stepMode][_currentStep] - 1 - _previousCycle;
+		return cycles > 0 ? (uint32_t)cycles : 0;
+	}
+
 	void GetMemoryRanges(MemoryRanges &ranges) override
 	{
 		ranges.AddHandler(MemoryOperation::Write, 0x4017);
@@ -195,6 +205,8 @@ public:
 		if(_inhibitIRQ) {
 			_console->GetCpu()->ClearIrqSource(IRQSource::FrameCounter);
 		}
+
+		_console->GetApu()->InvalidateNextRunCycle();
 	}
 
 	ApuFrameCounterState GetState()
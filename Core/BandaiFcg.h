@@ -124,6 +124,8 @@ protected:
 		}
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		if(_irqEnabled) {
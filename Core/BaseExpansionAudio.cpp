@@ -10,6 +10,12 @@ BaseExpansionAudio::BaseExpansionAudio(std::shared_ptr<Console> console)
 
 void BaseExpansionAudio::StreamState(bool saving)
 {
+	if(saving) {
+		//Block chips need to be up to date before their state is saved
+		_console->GetApu()->Run();
+	} else {
+		_previousCycle = 0;
+	}
 }
 
 void BaseExpansionAudio::Clock()
@@ -18,3 +24,16 @@ void BaseExpansionAudio::Clock()
 		ClockAudio();
 	}
 }
+
+void BaseExpansionAudio::Run(uint32_t currentCycle)
+{
+	if(currentCycle > _previousCycle) {
+		RunAudio(_previousCycle, currentCycle);
+		_previousCycle = currentCycle;
+	}
+}
+
+void BaseExpansionAudio::EndFrame()
+{
+	_previousCycle = 0;
+}
@@ -7,14 +7,25 @@ class MemoryManager;
 
 class BaseExpansionAudio : public Snapshotable
 {
+private:
+	uint32_t _previousCycle = 0;
+
 protected: 
 	std::shared_ptr<Console> _console = nullptr;
 
-	virtual void ClockAudio() = 0;
+	//Chips clocked by their mapper on every CPU cycle (see Clock)
+	virtual void ClockAudio() { }
+
+	//Chips that generate their output in blocks: output the samples for APU cycles [startCycle, endCycle) (timestamps are APU cycles)
+	//These chips register themselves with APU::SetExpansionAudio and are run by APU::Run, which must be called before their registers are accessed
+	virtual void RunAudio(uint32_t startCycle, uint32_t endCycle) { }
+
 	void StreamState(bool saving) override;
 
 public:
 	BaseExpansionAudio(std::shared_ptr<Console> console);
 
 	void Clock();
+	void Run(uint32_t currentCycle);
+	void EndFrame();
 };
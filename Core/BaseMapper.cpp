@@ -12,6 +12,8 @@
 void BaseMapper::WriteRegister(uint16_t addr, uint8_t value) { }
 uint8_t BaseMapper::ReadRegister(uint16_t addr) { return 0; }
 void BaseMapper::InitMapper(RomData &romData) { }
+std::atomic<uint32_t> BaseMapper::_nextRamStampMapperId(1);
+
 void BaseMapper::Reset(bool softReset) { }
 
 //Make sure the page size is no bigger than the size of the ROM itself
@@ -127,8 +129,30 @@ void BaseMapper::SetCpuMemoryMapping(uint16_t startAddr, uint16_t endAddr, uint8
 		_prgPages[i] = source;
 		_prgMemoryAccess[i] = accessType != -1 ? (MemoryAccessType)accessType : MemoryAccessType::Read;
 
+		vector<uint32_t>* stamps = GetRamPageStamps(source, _prgPageStampOffset[i]);
+		_prgPageStamps[i] = stamps ? stamps->data() : nullptr;
+
 		source += 0x100;
 	}
+
+	UpdateDirectReadPages(startAddr, endAddr);
+}
+
+void BaseMapper::UpdateDirectReadPages(uint8_t startPage, uint8_t endPage)
+{
+	//Also called while the mapper is being initialized, before the memory manager knows about it (the memory manager ignores these calls)
+	MemoryManager* memoryManager = _console ? _console->GetMemoryManager() : nullptr;
+	if(memoryManager) {
+		memoryManager->UpdateDirectReadPages(startPage, endPage);
+	}
+}
+
+uint8_t* BaseMapper::GetDirectReadPage(uint8_t page)
+{
+	if((_allowRegisterRead && _hasReadRegisterInPage[page]) || !(_prgMemoryAccess[page] & MemoryAccessType::Read)) {
+		return nullptr;
+	}
+	return _prgPages[page];
 }
 
 void BaseMapper::RemoveCpuMemoryMapping(uint16_t startAddr, uint16_t endAddr)
@@ -243,12 +267,137 @@ void BaseMapper::SetPpuMemoryMapping(uint16_t startAddr, uint16_t endAddr, uint8
 		_chrPages[i] = sourceMemory;
 		_chrMemoryAccess[i] = accessType != -1 ? (MemoryAccessType)accessType : MemoryAccessType::ReadWrite;
 
+		vector<uint32_t>* stamps = GetRamPageStamps(sourceMemory, _chrPageStampOffset[i]);
+		_chrPageStamps[i] = stamps ? stamps->data() : nullptr;
+
 		if(sourceMemory != nullptr) {
 			sourceMemory += 0x100;
 		}
 	}
 }
 
+vector<uint32_t>* BaseMapper::GetRamPageStamps(uint8_t* source, uint32_t &offset)
+{
+	auto contains = [=](uint8_t* ram, uint32_t size) {
+		return source != nullptr && ram != nullptr && source >= ram && source < ram + size;
+	};
+
+	vector<uint32_t>* stamps = nullptr;
+	uint8_t* ram = nullptr;
+	if(contains(_saveRam, _saveRamSize)) {
+		stamps = &_saveRamStamps;
+		ram = _saveRam;
+	} else if(contains(_workRam, _workRamSize)) {
+		stamps = &_workRamStamps;
+		ram = _workRam;
+	} else if(contains(_chrRam, _chrRamSize)) {
+		stamps = &_chrRamStamps;
+		ram = _chrRam;
+	} else if(contains(_nametableRam, BaseMapper::NametableSize * BaseMapper::NametableCount)) {
+		stamps = &_nametableRamStamps;
+		ram = _nametableRam;
+	}
+
+	offset = stamps ? (uint32_t)(source - ram) : 0;
+	return stamps;
+}
+
+void BaseMapper::MarkRamModified(uint8_t* ram, uint32_t length)
+{
+	uint32_t offset;
+	vector<uint32_t>* stamps = GetRamPageStamps(ram, offset);
+	if(stamps && length > 0) {
+		uint32_t lastPage = std::min((offset + length - 1) >> 8, (uint32_t)stamps->size() - 1);
+		for(uint32_t i = offset >> 8; i <= lastPage; i++) {
+			(*stamps)[i] = _ramStamp;
+		}
+	}
+}
+
+bool BaseMapper::IsValidRamStamp(uint64_t ramStamp)
+{
+	//Stamps of other mappers (e.g before a power cycle) can't be used to skip pages
+	return (uint32_t)(ramStamp >> 32) == _ramStampMapperId && (uint32_t)ramStamp <= _ramStamp;
+}
+
+void BaseMapper::MarkRamModified(BaseMapper* mapper, uint64_t sinceRamStamp)
+{
+	bool valid = mapper->IsValidRamStamp(sinceRamStamp);
+	uint32_t sinceStamp = (uint32_t)sinceRamStamp;
+	auto markPages = [=](vector<uint32_t> &stamps, vector<uint32_t> &sourceStamps) {
+		for(size_t i = 0; i < stamps.size(); i++) {
+			if(!valid || i >= sourceStamps.size() || sourceStamps[i] > sinceStamp) {
+				stamps[i] = _ramStamp;
+			}
+		}
+	};
+
+	markPages(_saveRamStamps, mapper->_saveRamStamps);
+	markPages(_workRamStamps, mapper->_workRamStamps);
+	markPages(_chrRamStamps, mapper->_chrRamStamps);
+	markPages(_nametableRamStamps, mapper->_nametableRamStamps);
+}
+
+void BaseMapper::MarkPrgRamModified()
+{
+	MarkRamModified(_saveRam, _saveRamSize);
+	MarkRamModified(_workRam, _workRamSize);
+}
+
+uint8_t* BaseMapper::GetRamPage(uint32_t index, uint32_t &size, uint32_t* &stamp)
+{
+	struct RamPages { uint8_t* Ram; uint32_t Size; vector<uint32_t> &Stamps; };
+	RamPages ramPages[4] = {
+		{ _saveRam, _saveRamSize, _saveRamStamps },
+		{ _workRam, _workRamSize, _workRamStamps },
+		{ _chrRam, _chrRamSize, _chrRamStamps },
+		{ _nametableRam, BaseMapper::NametableSize * BaseMapper::NametableCount, _nametableRamStamps }
+	};
+
+	for(RamPages &pages : ramPages) {
+		if(index < pages.Stamps.size()) {
+			uint32_t offset = index << 8;
+			size = offset < pages.Size ? std::min<uint32_t>(0x100, pages.Size - offset) : 0;
+			stamp = &pages.Stamps[index];
+			return pages.Ram + offset;
+		}
+		index -= (uint32_t)pages.Stamps.size();
+	}
+
+	size = 0;
+	stamp = nullptr;
+	return nullptr;
+}
+
+uint32_t BaseMapper::GetRamPageCount()
+{
+	return (uint32_t)(_saveRamStamps.size() + _workRamStamps.size() + _chrRamStamps.size() + _nametableRamStamps.size());
+}
+
+uint8_t* BaseMapper::GetRamPage(uint32_t index, uint32_t &size)
+{
+	uint32_t* stamp;
+	return GetRamPage(index, size, stamp);
+}
+
+bool BaseMapper::IsRamPageModified(uint32_t index, uint64_t sinceRamStamp)
+{
+	uint32_t size;
+	uint32_t* stamp;
+	GetRamPage(index, size, stamp);
+	return stamp && (!IsValidRamStamp(sinceRamStamp) || *stamp > (uint32_t)sinceRamStamp);
+}
+
+void BaseMapper::MarkRamPageModified(uint32_t index)
+{
+	uint32_t size;
+	uint32_t* stamp;
+	GetRamPage(index, size, stamp);
+	if(stamp) {
+		*stamp = _ramStamp;
+	}
+}
+
 void BaseMapper::RemovePpuMemoryMapping(uint16_t startAddr, uint16_t endAddr)
 {
 	//Unmap this section of memory (causing open bus behavior)
@@ -395,6 +544,7 @@ void BaseMapper::InitializeChrRam(int32_t chrRamSize)
 	if(_chrRamSize > 0) {
 		_chrRam = new uint8_t[_chrRamSize];
 		_console->InitializeRam(_chrRam, _chrRamSize);
+		_chrRamStamps.assign((_chrRamSize + 0xFF) >> 8, 0);
 	}
 }
 
@@ -428,6 +578,7 @@ void BaseMapper::AddRegisterRange(uint16_t startAddr, uint16_t endAddr, MemoryOp
 			_isWriteRegisterAddr[i] = true;
 		}
 	}
+	UpdateReadRegisterPages(startAddr, endAddr);
 }
 
 void BaseMapper::RemoveRegisterRange(uint16_t startAddr, uint16_t endAddr, MemoryOperation operation)
@@ -440,6 +591,21 @@ void BaseMapper::RemoveRegisterRange(uint16_t startAddr, uint16_t endAddr, Memor
 			_isWriteRegisterAddr[i] = false;
 		}
 	}
+	UpdateReadRegisterPages(startAddr, endAddr);
+}
+
+void BaseMapper::UpdateReadRegisterPages(uint16_t startAddr, uint16_t endAddr)
+{
+	for(int i = startAddr >> 8; i <= endAddr >> 8; i++) {
+		_hasReadRegisterInPage[i] = false;
+		for(int j = 0; j < 0x100; j++) {
+			if(_isReadRegisterAddr[(i << 8) | j]) {
+				_hasReadRegisterInPage[i] = true;
+				break;
+			}
+		}
+	}
+	UpdateDirectReadPages(startAddr >> 8, endAddr >> 8);
 }
 
 void BaseMapper::StreamState(bool saving)
@@ -447,10 +613,14 @@ void BaseMapper::StreamState(bool saving)
 	//Need to get the number of nametables in the state first, before we try to stream the nametable ram array
 	Stream(_nametableCount);
 
-	ArrayInfo<uint8_t> chrRam = { _chrRam, _chrRamSize };
-	ArrayInfo<uint8_t> workRam = { _workRam, _workRamSize };
-	ArrayInfo<uint8_t> saveRam = { _saveRam, _saveRamSize };
-	ArrayInfo<uint8_t> nametableRam = { _nametableRam, _nametableCount * BaseMapper::NametableSize };
+	//Loading: pages not written to since the saved stamp are skipped, saving: they are referenced instead of written
+	uint64_t ramStamp = saving ? _incrementalSaveStamp : _incrementalLoadStamp;
+	uint32_t savedStamp = (uint32_t)ramStamp;
+	bool incremental = IsValidRamStamp(ramStamp);
+	PagedArrayInfo chrRam = { _chrRam, _chrRamSize, _chrRamStamps.data(), _ramStamp, savedStamp, incremental };
+	PagedArrayInfo workRam = { _workRam, _workRamSize, _workRamStamps.data(), _ramStamp, savedStamp, incremental };
+	PagedArrayInfo saveRam = { _saveRam, _saveRamSize, _saveRamStamps.data(), _ramStamp, savedStamp, incremental };
+	PagedArrayInfo nametableRam = { _nametableRam, _nametableCount * BaseMapper::NametableSize, _nametableRamStamps.data(), _ramStamp, savedStamp, incremental };
 
 	ArrayInfo<int32_t> prgMemoryOffset = { _prgMemoryOffset, 0x100 };
 	ArrayInfo<int32_t> chrMemoryOffset = { _chrMemoryOffset, 0x40 };
@@ -461,6 +631,9 @@ void BaseMapper::StreamState(bool saving)
 
 	Stream(_mirroringType, chrRam, workRam, saveRam, nametableRam, prgMemoryOffset, chrMemoryOffset, prgMemoryType, chrMemoryType, prgMemoryAccess, chrMemoryAccess);
 
+	//Writes done after this point must be newer than the state's stamp
+	_ramStamp++;
+
 	if(!saving) {
 		RestorePrgChrState();
 	}
@@ -507,6 +680,7 @@ void BaseMapper::Initialize(RomData &romData)
 
 	memset(_isReadRegisterAddr, 0, sizeof(_isReadRegisterAddr));
 	memset(_isWriteRegisterAddr, 0, sizeof(_isWriteRegisterAddr));
+	memset(_hasReadRegisterInPage, 0, sizeof(_hasReadRegisterInPage));
 	AddRegisterRange(RegisterStartAddress(), RegisterEndAddress(), MemoryOperation::Any);
 
 	_prgSize = (uint32_t)romData.PrgRom.size();
@@ -539,6 +713,12 @@ void BaseMapper::Initialize(RomData &romData)
 	_nametableRam = new uint8_t[BaseMapper::NametableSize*BaseMapper::NametableCount];
 	_console->InitializeRam(_nametableRam, BaseMapper::NametableSize*BaseMapper::NametableCount);
 
+	//Stamps given out by other mappers are never valid for this one
+	_ramStampMapperId = _nextRamStampMapperId++;
+	_saveRamStamps.assign((_saveRamSize + 0xFF) >> 8, 0);
+	_workRamStamps.assign((_workRamSize + 0xFF) >> 8, 0);
+	_nametableRamStamps.assign(BaseMapper::NametableSize * BaseMapper::NametableCount >> 8, 0);
+
 	for(int i = 0; i < 0x100; i++) {
 		//Allow us to map a different page every 256 bytes
 		_prgPages[i] = nullptr;
@@ -737,6 +917,9 @@ void BaseMapper::WritePrgRam(uint16_t addr, uint8_t value)
 {
 	if(_prgMemoryAccess[addr >> 8] & MemoryAccessType::Write) {
 		_prgPages[addr >> 8][(uint8_t)addr] = value;
+		if(_prgPageStamps[addr >> 8]) {
+			_prgPageStamps[addr >> 8][(_prgPageStampOffset[addr >> 8] + (uint8_t)addr) >> 8] = _ramStamp;
+		}
 	}
 }
 
@@ -790,6 +973,9 @@ void BaseMapper::WriteVRAM(uint16_t addr, uint8_t value)
 {
 	if(_chrMemoryAccess[addr >> 8] & MemoryAccessType::Write) {
 		_chrPages[addr >> 8][(uint8_t)addr] = value;
+		if(_chrPageStamps[addr >> 8]) {
+			_chrPageStamps[addr >> 8][(_chrPageStampOffset[addr >> 8] + (uint8_t)addr) >> 8] = _ramStamp;
+		}
 	}
 }
 
@@ -834,10 +1020,10 @@ void BaseMapper::WriteMemory(DebugMemoryType type, uint8_t* buffer, int32_t leng
 	int32_t size = std::min(length, (int32_t)GetMemorySize(type));
 	switch(type) {
 		default: break;
-		case DebugMemoryType::ChrRam: memcpy(_chrRam, buffer, size); break;
-		case DebugMemoryType::SaveRam: memcpy(_saveRam, buffer, size); break;
-		case DebugMemoryType::WorkRam: memcpy(_workRam, buffer, size); break;
-		case DebugMemoryType::NametableRam: memcpy(_nametableRam, buffer, size); break;
+		case DebugMemoryType::ChrRam: memcpy(_chrRam, buffer, size); MarkRamModified(_chrRam, size); break;
+		case DebugMemoryType::SaveRam: memcpy(_saveRam, buffer, size); MarkRamModified(_saveRam, size); break;
+		case DebugMemoryType::WorkRam: memcpy(_workRam, buffer, size); MarkRamModified(_workRam, size); break;
+		case DebugMemoryType::NametableRam: memcpy(_nametableRam, buffer, size); MarkRamModified(_nametableRam, size); break;
 	}
 }
 
@@ -895,11 +1081,11 @@ void BaseMapper::SetMemoryValue(DebugMemoryType memoryType, uint32_t address, ui
 		switch(memoryType) {
 			default: break;
 			case DebugMemoryType::ChrRom: _chrRom[address] = value; break;
-			case DebugMemoryType::ChrRam: _chrRam[address] = value; break;
-			case DebugMemoryType::SaveRam: _saveRam[address] = value; break;
+			case DebugMemoryType::ChrRam: _chrRam[address] = value; MarkRamModified(_chrRam + address, 1); break;
+			case DebugMemoryType::SaveRam: _saveRam[address] = value; MarkRamModified(_saveRam + address, 1); break;
 			case DebugMemoryType::PrgRom: _prgRom[address] = value; break;
-			case DebugMemoryType::WorkRam: _workRam[address] = value; break;
-			case DebugMemoryType::NametableRam: _nametableRam[address] = value; break;
+			case DebugMemoryType::WorkRam: _workRam[address] = value; MarkRamModified(_workRam + address, 1); break;
+			case DebugMemoryType::NametableRam: _nametableRam[address] = value; MarkRamModified(_nametableRam + address, 1); break;
 		}
 	}
 }
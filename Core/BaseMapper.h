@@ -1,6 +1,7 @@
 #pragma once
 
 #include "stdafx.h"
+#include <atomic>
 #include "Snapshotable.h"
 #include "IMemoryHandler.h"
 #include "DebuggerTypes.h"
@@ -32,6 +33,7 @@ private:
 	bool _allowRegisterRead = false;
 	bool _isReadRegisterAddr[0x10000];
 	bool _isWriteRegisterAddr[0x10000];
+	bool _hasReadRegisterInPage[0x100] = {};
 
 	MemoryAccessType _prgMemoryAccess[0x100];
 	uint8_t* _prgPages[0x100];
@@ -48,6 +50,31 @@ private:
 	vector<uint8_t> _originalPrgRom;
 	vector<uint8_t> _originalChrRom;
 
+	//Write stamps for each 256-byte page of the RAM included in save states, used to skip unmodified pages when loading a state incrementally
+	//Each CPU/PPU page points to the stamps of the RAM it's mapped to (nullptr for ROM or memory that isn't part of BaseMapper's state)
+	vector<uint32_t> _saveRamStamps;
+	vector<uint32_t> _workRamStamps;
+	vector<uint32_t> _chrRamStamps;
+	vector<uint32_t> _nametableRamStamps;
+	uint32_t* _prgPageStamps[0x100] = {};
+	uint32_t _prgPageStampOffset[0x100] = {};
+	uint32_t* _chrPageStamps[0x100] = {};
+	uint32_t _chrPageStampOffset[0x100] = {};
+	uint64_t _incrementalLoadStamp = 0;
+	uint64_t _incrementalSaveStamp = 0;
+
+	//Incremented every time a state is saved or loaded, the stamps given to callers also contain the mapper's ID (stamps of other mappers are never used)
+	uint32_t _ramStamp = 1;
+	uint32_t _ramStampMapperId = 0;
+	static std::atomic<uint32_t> _nextRamStampMapperId;
+
+	vector<uint32_t>* GetRamPageStamps(uint8_t* source, uint32_t &offset);
+	uint8_t* GetRamPage(uint32_t index, uint32_t &size, uint32_t* &stamp);
+	bool IsValidRamStamp(uint64_t ramStamp);
+
+	void UpdateReadRegisterPages(uint16_t startAddr, uint16_t endAddr);
+	void UpdateDirectReadPages(uint8_t startPage, uint8_t endPage);
+
 protected:
 	RomInfo _romInfo;
 
@@ -135,6 +162,9 @@ protected:
 
 	void InitializeChrRam(int32_t chrRamSize = -1);
 
+	//Must be called when the mapper modifies its save/work/CHR/nametable RAM directly, rather than via WritePrgRam/WriteVRAM
+	void MarkRamModified(uint8_t* ram, uint32_t length);
+
 	void AddRegisterRange(uint16_t startAddr, uint16_t endAddr, MemoryOperation operation = MemoryOperation::Any);
 	void RemoveRegisterRange(uint16_t startAddr, uint16_t endAddr, MemoryOperation operation = MemoryOperation::Any);
 
@@ -162,12 +192,46 @@ public:
 	virtual ConsoleFeatures GetAvailableFeatures();
 
 	virtual void SetNesModel(NesModel model) { }
+
+	//Most boards don't need to be clocked on every CPU cycle - mappers that override ProcessCpuClock must return true, otherwise it is never called
+	virtual bool RequiresCpuClock() { return false; }
 	virtual void ProcessCpuClock() { }
 	virtual void NotifyVRAMAddressChange(uint16_t addr);
+
+	//Mappers that react to the PPU's bus activity in a way the CPU can observe (e.g A12-based scanline IRQs) must return true
+	//This keeps the PPU running in lockstep with the CPU when lazy PPU scheduling is enabled
+	virtual bool RequiresPpuSync() { return false; }
+	bool IsReadRegisterAddr(uint16_t addr) { return _isReadRegisterAddr[addr]; }
 	virtual void GetMemoryRanges(MemoryRanges &ranges) override;
 	
 	virtual void SaveBattery() override;
 
+	//Stamp of the next state that will be saved/loaded - keep it along with the state to be able to load it (or save the next one) incrementally
+	uint64_t GetRamStamp() { return ((uint64_t)_ramStampMapperId << 32) | _ramStamp; }
+
+	//When set, the next load only copies the RAM pages written to since the state with this stamp was saved (0 = load everything)
+	//Only valid for states saved by this console, when nothing outside the emulation core modified the RAM since then
+	void SetIncrementalLoad(uint64_t savedRamStamp) { _incrementalLoadStamp = savedRamStamp; }
+
+	//When set, the next save only contains the RAM pages written to since the state with this stamp was saved/loaded, the other pages are referenced (0 = save everything)
+	//Such a state can only be loaded by a console whose referenced pages already match this console's (e.g the run-ahead console)
+	void SetIncrementalSave(uint64_t baseRamStamp) { _incrementalSaveStamp = baseRamStamp; }
+
+	//Marks the pages another mapper (for the same game) wrote to since the given stamp as modified, to include them in the next incremental save
+	void MarkRamModified(BaseMapper* mapper, uint64_t sinceRamStamp);
+
+	//Marks all work/save RAM pages as modified - must be called when something outside the emulation core may have written to them (e.g the frontend, via GetWorkRam/GetSaveRam)
+	void MarkPrgRamModified();
+
+	//The RAM included in save states (save, work, CHR and nametable RAM, in that order) as a list of 256-byte pages
+	//Lets a caller keep its own copy of the RAM up to date without saving all of it (see RewindManager)
+	uint32_t GetRamPageCount();
+	uint8_t* GetRamPage(uint32_t index, uint32_t &size);
+	//Always true when the stamp isn't valid (e.g it was given by another mapper)
+	bool IsRamPageModified(uint32_t index, uint64_t sinceRamStamp);
+	//Must be called after writing to a page returned by GetRamPage
+	void MarkRamPageModified(uint32_t index);
+
 	void SetConsole(std::shared_ptr<Console> console);
 
 	std::shared_ptr<BaseControlDevice> GetMapperControlDevice();
@@ -179,6 +243,8 @@ public:
 	uint8_t ReadRAM(uint16_t addr) override;
 	uint8_t PeekRAM(uint16_t addr) override;
 	uint8_t DebugReadRAM(uint16_t addr);
+	//Returns the memory that ReadRAM would read for this page, or nullptr if ReadRAM must be called (registers, open bus, etc.)
+	virtual uint8_t* GetDirectReadPage(uint8_t page);
 	void WriteRAM(uint16_t addr, uint8_t value) override;
 	void DebugWriteRAM(uint16_t addr, uint8_t value);
 	void WritePrgRam(uint16_t addr, uint8_t value);
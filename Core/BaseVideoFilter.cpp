@@ -35,6 +35,13 @@ void BaseVideoFilter::UpdateBufferSize()
 	}
 }
 
+void BaseVideoFilter::InitScanlineLut(uint8_t lut[256], double scanlineIntensity)
+{
+	for(int i = 0; i < 256; i++) {
+		lut[i] = (uint8_t)(i * scanlineIntensity);
+	}
+}
+
 OverscanDimensions BaseVideoFilter::GetOverscan()
 {
 	return _overscan;
@@ -33,4 +33,11 @@ public:
 
 	virtual OverscanDimensions GetOverscan();
 	virtual FrameInfo GetFrameInfo() = 0;
+
+	//Scanline darkening shared by the filters: the table maps each color channel to its darkened value
+	static void InitScanlineLut(uint8_t lut[256], double scanlineIntensity);
+	static uint32_t ApplyScanlineLut(const uint8_t lut[256], uint32_t color)
+	{
+		return 0xFF000000 | (lut[(color >> 16) & 0xFF] << 16) | (lut[(color >> 8) & 0xFF] << 8) | lut[color & 0xFF];
+	}
 };
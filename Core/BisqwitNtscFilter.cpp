@@ -11,8 +11,6 @@
 BisqwitNtscFilter::BisqwitNtscFilter(shared_ptr<Console> console, int resDivider) : BaseVideoFilter(console)
 {
 	_resDivider = resDivider;
-	_stopThread = false;
-	_workDone = false;
 
 	const int8_t signalLumaLow[4] = { -29, -15, 22, 71 };
 	const int8_t signalLumaHigh[4] = { 32, 66, 105, 105 };
@@ -31,46 +29,45 @@ BisqwitNtscFilter::BisqwitNtscFilter(shared_ptr<Console> console, int resDivider
 		_signalLow[i] = m;
 		_signalHigh[i] = q;
 	}
-
-	_extraThread = std::thread([=]() {
-		//Worker thread to improve decode speed
-		while(!_stopThread) {
-			_waitWork.Wait();
-			if(_stopThread) {
-				break;
-			}
-
-			uint32_t* outputBuffer = GetOutputBuffer();
-
-			//Adjust outputbuffer to start at the middle of the picture
-			if(_keepVerticalRes) {
-				outputBuffer += GetOverscan().GetScreenWidth() * 8 / _resDivider * (120 - GetOverscan().Top);
-			} else {
-				outputBuffer += GetOverscan().GetScreenWidth() * 64 / _resDivider / _resDivider * (120 - GetOverscan().Top);
-			}
-
-			DecodeFrame(120, 239 - GetOverscan().Bottom, _ppuOutputBuffer, outputBuffer, (IsOddFrame() ? 8 : 0) + 327360); 
-
-			_workDone = true;
-		}
-	});
 }
 
 BisqwitNtscFilter::~BisqwitNtscFilter()
 {
-	_stopThread = true;
-	_waitWork.Signal();
-	_extraThread.join();
 }
 
 void BisqwitNtscFilter::ApplyFilter(uint16_t *ppuOutputBuffer)
 {
 	_ppuOutputBuffer = ppuOutputBuffer;
 
-	_workDone = false;
-	_waitWork.Signal();
-	DecodeFrame(GetOverscan().Top, 120, ppuOutputBuffer, GetOutputBuffer(), (IsOddFrame() ? 8 : 0) + GetOverscan().Top*341*8);
-	while(!_workDone) {}
+	uint32_t threadCount = _console->GetSettings()->GetVideoFilterThreadCount();
+	if(threadCount == 0) {
+		threadCount = ThreadPool::GetDefaultThreadCount();
+	}
+	if(!_threadPool || _threadPool->GetThreadCount() != threadCount) {
+		_threadPool.reset(new ThreadPool(threadCount));
+	}
+
+	OverscanDimensions overscan = GetOverscan();
+	int firstRow = overscan.Top;
+	int rowCount = 240 - overscan.Top - overscan.Bottom;
+	uint32_t bandCount = std::min<uint32_t>(threadCount, rowCount);
+
+	uint32_t pixelsPerCycle = 8 / _resDivider;
+	uint32_t rowPixelGap = overscan.GetScreenWidth() * pixelsPerCycle * (_keepVerticalRes ? 1 : pixelsPerCycle);
+
+	_bandNextRows.resize(bandCount);
+	for(vector<uint32_t> &row : _bandNextRows) {
+		row.resize(overscan.GetScreenWidth() * pixelsPerCycle + 16);
+	}
+
+	_threadPool->Run(bandCount, [=](uint32_t band) {
+		int startRow = firstRow + rowCount * band / bandCount;
+		int endRow = firstRow + rowCount * (band + 1) / bandCount - 1;
+
+		//Each scanline is 341 PPU cycles long, 8 signal samples per cycle
+		int startPhase = (IsOddFrame() ? 8 : 0) + startRow * 341 * 8;
+		DecodeFrame(startRow, endRow, GetOutputBuffer() + rowPixelGap * (startRow - firstRow), startPhase, _bandNextRows[band].data());
+	});
 }
 
 FrameInfo BisqwitNtscFilter::GetFrameInfo()
@@ -192,7 +189,7 @@ void BisqwitNtscFilter::GenerateNtscSignal(int8_t *ntscSignal, int &phase, int r
 	phase += (341 - 256 - _paddingSize * 2) * _signalsPerPixel;
 }
 
-void BisqwitNtscFilter::DecodeFrame(int startRow, int endRow, uint16_t *ppuOutputBuffer, uint32_t* outputBuffer, int startPhase)
+void BisqwitNtscFilter::DecodeFrame(int startRow, int endRow, uint32_t* outputBuffer, int startPhase, uint32_t* nextRowBuffer)
 {
 	int pixelsPerCycle = 8 / _resDivider;
 	int phase = startPhase;
@@ -218,13 +215,27 @@ void BisqwitNtscFilter::DecodeFrame(int startRow, int endRow, uint16_t *ppuOutpu
 	}
 
 	if(!_keepVerticalRes) {
+		int lastRow = 239 - GetOverscan().Bottom;
+		if(endRow < lastRow) {
+			//The last row of the band is blended with the first row of the next band, which is being decoded by another thread - decode a private copy of it
+			int startCycle = phase % 12;
+			GenerateNtscSignal(rowSignal, phase, endRow + 1);
+			NtscDecodeLine(lineWidth * _signalsPerPixel, rowSignal, nextRowBuffer, (startCycle + 7) % 12);
+		}
+
 		//Generate the missing vertical lines
 		outputBuffer = orgBuffer;
-		int lastRow = 239 - GetOverscan().Bottom;
 		bool verticalBlend = _console->GetSettings()->GetNtscFilterSettings().VerticalBlend;
 		for(int y = startRow; y <= endRow; y++) {
 			uint64_t* currentLine = (uint64_t*)outputBuffer;
-			uint64_t* nextLine = y == lastRow ? currentLine : (uint64_t*)(outputBuffer + rowPixelGap);
+			uint64_t* nextLine;
+			if(y == lastRow) {
+				nextLine = currentLine;
+			} else if(y == endRow) {
+				nextLine = (uint64_t*)nextRowBuffer;
+			} else {
+				nextLine = (uint64_t*)(outputBuffer + rowPixelGap);
+			}
 			uint64_t* buffer = (uint64_t*)(outputBuffer + rowPixelGap / 2);
 
 			RecursiveBlend(4 / _resDivider, buffer, currentLine, nextLine, pixelsPerCycle, verticalBlend);
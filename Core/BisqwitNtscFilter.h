@@ -4,7 +4,7 @@
 #pragma once
 #include "stdafx.h"
 #include "BaseVideoFilter.h"
-#include "../Utilities/AutoResetEvent.h"
+#include "../Utilities/ThreadPool.h"
 
 class BisqwitNtscFilter : public BaseVideoFilter
 {
@@ -14,10 +14,9 @@ private:
 	static constexpr int _signalsPerPixel = 8;
 	static constexpr int _signalWidth = 258;
 
-	std::thread _extraThread;
-	AutoResetEvent _waitWork;
-	atomic<bool> _stopThread;
-	atomic<bool> _workDone;
+	//Rows are independent (apart from the vertical blending), the frame is split into bands decoded in parallel
+	std::unique_ptr<ThreadPool> _threadPool;
+	vector<vector<uint32_t>> _bandNextRows;
 
 	bool _keepVerticalRes = false;
 
@@ -46,7 +45,7 @@ private:
 	void NtscDecodeLine(int width, const int8_t* signal, uint32_t* target, int phase0);
 	
 	void GenerateNtscSignal(int8_t *ntscSignal, int &phase, int rowNumber);
-	void DecodeFrame(int startRow, int endRow, uint16_t *ppuOutputBuffer, uint32_t* outputBuffer, int startPhase);
+	void DecodeFrame(int startRow, int endRow, uint32_t* outputBuffer, int startPhase, uint32_t* nextRowBuffer);
 	void OnBeforeApplyFilter();
 
 public:
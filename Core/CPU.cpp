@@ -6,12 +6,15 @@
 #include "APU.h"
 #include "DeltaModulationChannel.h"
 #include "MemoryManager.h"
+#include "BaseMapper.h"
 #include "Console.h"
+#include "Profiler.h"
 
 CPU::CPU(shared_ptr<Console> console)
 {
 	_console = console;
 	_memoryManager = _console->GetMemoryManager();
+	_mapper = _console->GetMapper();
 
 	Func opTable[] = { 
 	//	0				1				2				3				4				5				6						7				8				9				A						B				C						D				E						F
@@ -54,9 +57,38 @@ CPU::CPU(shared_ptr<Console> console)
 		M::Rel,	M::IndY,		M::None,	M::IndYW,	M::ZeroX,	M::ZeroX,	M::ZeroX,	M::ZeroX,	M::Imp,	M::AbsY,	M::Imp,	M::AbsYW,M::AbsX,	M::AbsX,	M::AbsXW,M::AbsXW,//F
 	};
 	
-	memcpy(_opTable, opTable, sizeof(opTable));
+	memcpy(_legacyOpTable, opTable, sizeof(opTable));
 	memcpy(_addrMode, addrMode, sizeof(addrMode));
 
+	//Same tables as above, with each opcode's addressing mode and operation fused into a single handler at compile time
+	#define OP(op, mode) &CPU::ExecOpCode<M::mode, &CPU::op>
+	Func fusedOpTable[] = {
+		OP(BRK, Imp), OP(ORA, IndX), OP(HLT, None), OP(SLO, IndX), OP(NOP, Zero), OP(ORA, Zero), OP(ASL_Memory, Zero), OP(SLO, Zero), OP(PHP, Imp), OP(ORA, Imm), OP(ASL_Acc, Acc), OP(AAC, Imm), OP(NOP, Abs), OP(ORA, Abs), OP(ASL_Memory, Abs), OP(SLO, Abs), //0
+		OP(BPL, Rel), OP(ORA, IndY), OP(HLT, None), OP(SLO, IndYW), OP(NOP, ZeroX), OP(ORA, ZeroX), OP(ASL_Memory, ZeroX), OP(SLO, ZeroX), OP(CLC, Imp), OP(ORA, AbsY), OP(NOP, Imp), OP(SLO, AbsYW), OP(NOP, AbsX), OP(ORA, AbsX), OP(ASL_Memory, AbsXW), OP(SLO, AbsXW), //1
+		OP(JSR, Abs), OP(AND, IndX), OP(HLT, None), OP(RLA, IndX), OP(BIT, Zero), OP(AND, Zero), OP(ROL_Memory, Zero), OP(RLA, Zero), OP(PLP, Imp), OP(AND, Imm), OP(ROL_Acc, Acc), OP(AAC, Imm), OP(BIT, Abs), OP(AND, Abs), OP(ROL_Memory, Abs), OP(RLA, Abs), //2
+		OP(BMI, Rel), OP(AND, IndY), OP(HLT, None), OP(RLA, IndYW), OP(NOP, ZeroX), OP(AND, ZeroX), OP(ROL_Memory, ZeroX), OP(RLA, ZeroX), OP(SEC, Imp), OP(AND, AbsY), OP(NOP, Imp), OP(RLA, AbsYW), OP(NOP, AbsX), OP(AND, AbsX), OP(ROL_Memory, AbsXW), OP(RLA, AbsXW), //3
+		OP(RTI, Imp), OP(EOR, IndX), OP(HLT, None), OP(SRE, IndX), OP(NOP, Zero), OP(EOR, Zero), OP(LSR_Memory, Zero), OP(SRE, Zero), OP(PHA, Imp), OP(EOR, Imm), OP(LSR_Acc, Acc), OP(ASR, Imm), OP(JMP_Abs, Abs), OP(EOR, Abs), OP(LSR_Memory, Abs), OP(SRE, Abs), //4
+		OP(BVC, Rel), OP(EOR, IndY), OP(HLT, None), OP(SRE, IndYW), OP(NOP, ZeroX), OP(EOR, ZeroX), OP(LSR_Memory, ZeroX), OP(SRE, ZeroX), OP(CLI, Imp), OP(EOR, AbsY), OP(NOP, Imp), OP(SRE, AbsYW), OP(NOP, AbsX), OP(EOR, AbsX), OP(LSR_Memory, AbsXW), OP(SRE, AbsXW), //5
+		OP(RTS, Imp), OP(ADC, IndX), OP(HLT, None), OP(RRA, IndX), OP(NOP, Zero), OP(ADC, Zero), OP(ROR_Memory, Zero), OP(RRA, Zero), OP(PLA, Imp), OP(ADC, Imm), OP(ROR_Acc, Acc), OP(ARR, Imm), OP(JMP_Ind, Ind), OP(ADC, Abs), OP(ROR_Memory, Abs), OP(RRA, Abs), //6
+		OP(BVS, Rel), OP(ADC, IndY), OP(HLT, None), OP(RRA, IndYW), OP(NOP, ZeroX), OP(ADC, ZeroX), OP(ROR_Memory, ZeroX), OP(RRA, ZeroX), OP(SEI, Imp), OP(ADC, AbsY), OP(NOP, Imp), OP(RRA, AbsYW), OP(NOP, AbsX), OP(ADC, AbsX), OP(ROR_Memory, AbsXW), OP(RRA, AbsXW), //7
+		OP(NOP, Imm), OP(STA, IndX), OP(NOP, Imm), OP(SAX, IndX), OP(STY, Zero), OP(STA, Zero), OP(STX, Zero), OP(SAX, Zero), OP(DEY, Imp), OP(NOP, Imm), OP(TXA, Imp), OP(UNK, Imm), OP(STY, Abs), OP(STA, Abs), OP(STX, Abs), OP(SAX, Abs), //8
+		OP(BCC, Rel), OP(STA, IndYW), OP(HLT, None), OP(AXA, IndYW), OP(STY, ZeroX), OP(STA, ZeroX), OP(STX, ZeroY), OP(SAX, ZeroY), OP(TYA, Imp), OP(STA, AbsYW), OP(TXS, Imp), OP(TAS, AbsYW), OP(SYA, AbsXW), OP(STA, AbsXW), OP(SXA, AbsYW), OP(AXA, AbsYW), //9
+		OP(LDY, Imm), OP(LDA, IndX), OP(LDX, Imm), OP(LAX, IndX), OP(LDY, Zero), OP(LDA, Zero), OP(LDX, Zero), OP(LAX, Zero), OP(TAY, Imp), OP(LDA, Imm), OP(TAX, Imp), OP(ATX, Imm), OP(LDY, Abs), OP(LDA, Abs), OP(LDX, Abs), OP(LAX, Abs), //A
+		OP(BCS, Rel), OP(LDA, IndY), OP(HLT, None), OP(LAX, IndY), OP(LDY, ZeroX), OP(LDA, ZeroX), OP(LDX, ZeroY), OP(LAX, ZeroY), OP(CLV, Imp), OP(LDA, AbsY), OP(TSX, Imp), OP(LAS, AbsY), OP(LDY, AbsX), OP(LDA, AbsX), OP(LDX, AbsY), OP(LAX, AbsY), //B
+		OP(CPY, Imm), OP(CPA, IndX), OP(NOP, Imm), OP(DCP, IndX), OP(CPY, Zero), OP(CPA, Zero), OP(DEC, Zero), OP(DCP, Zero), OP(INY, Imp), OP(CPA, Imm), OP(DEX, Imp), OP(AXS, Imm), OP(CPY, Abs), OP(CPA, Abs), OP(DEC, Abs), OP(DCP, Abs), //C
+		OP(BNE, Rel), OP(CPA, IndY), OP(HLT, None), OP(DCP, IndYW), OP(NOP, ZeroX), OP(CPA, ZeroX), OP(DEC, ZeroX), OP(DCP, ZeroX), OP(CLD, Imp), OP(CPA, AbsY), OP(NOP, Imp), OP(DCP, AbsYW), OP(NOP, AbsX), OP(CPA, AbsX), OP(DEC, AbsXW), OP(DCP, AbsXW), //D
+		OP(CPX, Imm), OP(SBC, IndX), OP(NOP, Imm), OP(ISB, IndX), OP(CPX, Zero), OP(SBC, Zero), OP(INC, Zero), OP(ISB, Zero), OP(INX, Imp), OP(SBC, Imm), OP(NOP, Imp), OP(SBC, Imm), OP(CPX, Abs), OP(SBC, Abs), OP(INC, Abs), OP(ISB, Abs), //E
+		OP(BEQ, Rel), OP(SBC, IndY), OP(HLT, None), OP(ISB, IndYW), OP(NOP, ZeroX), OP(SBC, ZeroX), OP(INC, ZeroX), OP(ISB, ZeroX), OP(SED, Imp), OP(SBC, AbsY), OP(NOP, Imp), OP(ISB, AbsYW), OP(NOP, AbsX), OP(SBC, AbsX), OP(INC, AbsXW), OP(ISB, AbsXW) //F
+	};
+	#undef OP
+	memcpy(_fusedOpTable, fusedOpTable, sizeof(fusedOpTable));
+
+#ifdef MESEN_LEGACY_CPU_DISPATCH
+	SetLegacyDispatch(true);
+#else
+	SetLegacyDispatch(false);
+#endif
+
 	_instAddrMode = AddrMode::None;
 	_state = {};
 	_cycleCount = 0;
@@ -130,6 +162,7 @@ void CPU::Reset(bool softReset, NesModel model)
 
 	_cycleCount = -1;
 	_masterClock = 0;
+	_ppuSyncClock = 0;
 
 	uint8_t cpuOffset = 0;
 	if(_console->GetSettings()->CheckFlag(EmulationFlags::RandomizeCpuPpuAlignment)) {
@@ -155,9 +188,8 @@ void CPU::Reset(bool softReset, NesModel model)
 
 void CPU::Exec()
 {
+	PROFILE_SECTION(ProfilerSection::Cpu);
 	uint8_t opCode = GetOPCode();
-	_instAddrMode = _addrMode[opCode];
-	_operand = FetchOperand();
 	(this->*_opTable[opCode])();
 	
 	if(_prevRunIrq || _prevNeedNmi) {
@@ -217,6 +249,10 @@ void CPU::MemoryWrite(uint16_t addr, uint8_t value, MemoryOperationType operatio
 	}
 #else
 	_cpuWrite = true;
+	if(addr >= 0x2000) {
+		//PPU registers, APU/input registers & mapper registers (which can change CHR banks, mirroring, etc.)
+		_ppuSyncClock = 0;
+	}
 	StartCpuCycle(false);
 	_memoryManager->Write(addr, value, operationType);
 	EndCpuCycle(false);
@@ -237,6 +273,9 @@ uint8_t CPU::MemoryRead(uint16_t addr, MemoryOperationType operationType) {
 #else 
 	ProcessPendingDma(addr);
 
+	if(_lazyPpu && IsPpuSyncRead(addr)) {
+		_ppuSyncClock = 0;
+	}
 	StartCpuCycle(true);
 	uint8_t value = _memoryManager->Read(addr, operationType);
 	EndCpuCycle(true);
@@ -244,9 +283,9 @@ uint8_t CPU::MemoryRead(uint16_t addr, MemoryOperationType operationType) {
 #endif
 }
 
-uint16_t CPU::FetchOperand()
+uint16_t CPU::FetchOperand(AddrMode mode)
 {
-	switch(_instAddrMode) {
+	switch(mode) {
 		case AddrMode::Acc:
 		case AddrMode::Imp: DummyRead(); return 0;
 		case AddrMode::Imm:
@@ -269,10 +308,51 @@ uint16_t CPU::FetchOperand()
 	return 0;
 }
 
+bool CPU::IsPpuSyncRead(uint16_t addr)
+{
+	//PPU registers, input ports (zapper) and readable mapper registers (some mappers switch banks on reads)
+	return (addr >= 0x2000 && addr < 0x4000) || addr == 0x4016 || addr == 0x4017 || _mapper->IsReadRegisterAddr(addr);
+}
+
+void CPU::SyncPpu()
+{
+	PPU* ppu = _console->GetPpu();
+	ppu->Run(_masterClock - _ppuOffset);
+	if(_lazyPpu) {
+		_ppuSyncClock = ppu->GetNextEventClock() + _ppuOffset;
+	}
+}
+
+void CPU::SetLazyPpu(bool enabled)
+{
+	_lazyPpu = enabled;
+	_ppuSyncClock = 0;
+}
+
+void CPU::SetLegacyDispatch(bool enabled)
+{
+	if(enabled) {
+		#define L4(n) &CPU::ExecLegacyOpCode<n>, &CPU::ExecLegacyOpCode<n + 1>, &CPU::ExecLegacyOpCode<n + 2>, &CPU::ExecLegacyOpCode<n + 3>
+		#define L16(n) L4(n), L4(n + 4), L4(n + 8), L4(n + 12)
+		Func legacyDispatchTable[] = {
+			L16(0x00), L16(0x10), L16(0x20), L16(0x30), L16(0x40), L16(0x50), L16(0x60), L16(0x70),
+			L16(0x80), L16(0x90), L16(0xA0), L16(0xB0), L16(0xC0), L16(0xD0), L16(0xE0), L16(0xF0)
+		};
+		#undef L16
+		#undef L4
+		static_assert(sizeof(legacyDispatchTable) == sizeof(_opTable), "Invalid legacy dispatch table");
+		memcpy(_opTable, legacyDispatchTable, sizeof(legacyDispatchTable));
+	} else {
+		memcpy(_opTable, _fusedOpTable, sizeof(_fusedOpTable));
+	}
+}
+
 void CPU::EndCpuCycle(bool forRead)
 {
 	_masterClock += forRead ? (_endClockCount + 1) : (_endClockCount - 1);
-	_console->GetPpu()->Run(_masterClock - _ppuOffset);
+	if(_masterClock >= _ppuSyncClock) {
+		SyncPpu();
+	}
 
 	//"The internal signal goes high during φ1 of the cycle that follows the one where the edge is detected,
 	//and stays high until the NMI has been handled. "
@@ -296,7 +376,9 @@ void CPU::StartCpuCycle(bool forRead)
 {
 	_masterClock += forRead ? (_startClockCount - 1) : (_startClockCount + 1);
 	_cycleCount++;
-	_console->GetPpu()->Run(_masterClock - _ppuOffset);
+	if(_masterClock >= _ppuSyncClock) {
+		SyncPpu();
+	}
 	_console->ProcessCpuClock();
 }
 
@@ -307,6 +389,7 @@ void CPU::ProcessPendingDma(uint16_t readAddress)
 	}
 
 	//"If this cycle is a read, hijack the read, discard the value, and prevent all other actions that occur on this cycle (PC not incremented, etc)"
+	_ppuSyncClock = 0;
 	StartCpuCycle(true);
 	_memoryManager->Read(readAddress, MemoryOperationType::DummyRead);
 	EndCpuCycle(true);
@@ -324,6 +407,8 @@ void CPU::ProcessPendingDma(uint16_t readAddress)
 		} else if(_needDummyRead) {
 			_needDummyRead = false;
 		}
+		//DMA cycles access $2004 and can read from registers, keep the PPU in sync
+		_ppuSyncClock = 0;
 		StartCpuCycle(true);
 	};
 
@@ -427,6 +512,12 @@ void CPU::StreamState(bool saving)
 	uint32_t extraScanlinesAfterNmi = settings->GetPpuExtraScanlinesAfterNmi();
 	uint32_t dipSwitches = _console->GetSettings()->GetDipSwitches();
 
+	if(saving) {
+		//Catch up the PPU to make sure the state is identical to the one produced without lazy PPU scheduling
+		_console->GetPpu()->Run(_masterClock - _ppuOffset);
+	}
+	_ppuSyncClock = 0;
+
 	Stream(_state.PC, _state.SP, _state.PS, _state.A, _state.X, _state.Y, _cycleCount, _state.NMIFlag, 
 			_state.IRQFlag, _dmcDmaRunning, _spriteDmaTransfer,
 			extraScanlinesBeforeNmi, extraScanlinesBeforeNmi, dipSwitches,
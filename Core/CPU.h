@@ -13,6 +13,7 @@
 enum class NesModel;
 class Console;
 class MemoryManager;
+class BaseMapper;
 class DummyCpu;
 
 class CPU : public Snapshotable
@@ -40,6 +41,8 @@ private:
 	uint16_t _operand;
 
 	Func _opTable[256];
+	Func _fusedOpTable[256];
+	Func _legacyOpTable[256];
 	AddrMode _addrMode[256];
 	AddrMode _instAddrMode;
 
@@ -66,6 +69,11 @@ private:
 
 	uint64_t _lastCrashWarning = 0;
 
+	//Lazy PPU scheduling: the PPU is only caught up when the CPU reaches _ppuSyncClock, or before accessing a register that can observe/alter its state
+	BaseMapper* _mapper;
+	bool _lazyPpu = false;
+	uint64_t _ppuSyncClock = 0;
+
 #ifdef DUMMYCPU
 	uint32_t _writeCounter = 0;
 	uint16_t _writeAddresses[10];
@@ -80,10 +88,29 @@ private:
 
 	__forceinline void StartCpuCycle(bool forRead);
 	__forceinline void ProcessPendingDma(uint16_t readAddress);
-	__forceinline uint16_t FetchOperand();
+	__forceinline uint16_t FetchOperand(AddrMode mode);
 	__forceinline void EndCpuCycle(bool forRead);
+	__forceinline void SyncPpu();
+	__forceinline bool IsPpuSyncRead(uint16_t addr);
 	void IRQ();
 
+	template<AddrMode mode, Func op>
+	void ExecOpCode()
+	{
+		_instAddrMode = mode;
+		_operand = FetchOperand(mode);
+		(this->*op)();
+	}
+
+	//Original dispatch: addressing mode and operation looked up at run time (see SetLegacyDispatch)
+	template<uint8_t opCode>
+	void ExecLegacyOpCode()
+	{
+		_instAddrMode = _addrMode[opCode];
+		_operand = FetchOperand(_instAddrMode);
+		(this->*_legacyOpTable[opCode])();
+	}
+
 	uint8_t GetOPCode()
 	{
 		uint8_t opCode = MemoryRead(_state.PC, MemoryOperationType::ExecOpCode);
@@ -799,6 +826,10 @@ public:
 
 	void RunDMATransfer(uint8_t offsetValue);
 	void StartDmcTransfer();
+	void SetLazyPpu(bool enabled);
+
+	//Switches between the fused per-opcode handlers and the original table-driven dispatch (used to check that both behave identically)
+	void SetLegacyDispatch(bool enabled);
 
 	uint32_t GetClockRate(NesModel model);
 	bool IsCpuWrite() { return _cpuWrite; }
@@ -3,6 +3,7 @@
 #include "CheatManager.h"
 #include "Console.h"
 #include "BaseMapper.h"
+#include "MemoryManager.h"
 
 CheatManager::CheatManager(std::shared_ptr<Console> console)
 {
@@ -94,10 +95,21 @@ void CheatManager::AddCode(CodeInfo &code)
 			_relativeCheatCodes[code.Address].reset(new vector<CodeInfo>());
 		}
 		_relativeCheatCodes[code.Address]->push_back(code);
+		_pagesWithCodes[code.Address >> 8] = true;
 	} else {
 		_absoluteCheatCodes.push_back(code);
 	}
 	_hasCode = true;
+	UpdateDirectReadPages();
+}
+
+void CheatManager::UpdateDirectReadPages()
+{
+	//Pages affected by cheats must go through ApplyCodes, prevent the memory manager from reading them directly
+	MemoryManager* memoryManager = _console->GetMemoryManager();
+	if(memoryManager) {
+		memoryManager->UpdateDirectReadPages();
+	}
 }
 
 void CheatManager::AddGameGenieCode(string code)
@@ -136,7 +148,24 @@ void CheatManager::ClearCodes()
 
 	cheatRemoved |= _absoluteCheatCodes.size() > 0;
 	_absoluteCheatCodes.clear();
+	memset(_pagesWithCodes, 0, sizeof(_pagesWithCodes));
 	_hasCode = false;
+	UpdateDirectReadPages();
+}
+
+void CheatManager::CopyCodes(CheatManager* source)
+{
+	ClearCodes();
+	for(std::unique_ptr<vector<CodeInfo>> &codes : source->_relativeCheatCodes) {
+		if(codes) {
+			for(CodeInfo &code : *codes) {
+				AddCode(code);
+			}
+		}
+	}
+	for(CodeInfo &code : source->_absoluteCheatCodes) {
+		AddCode(code);
+	}
 }
 
 void CheatManager::ApplyCodes(uint16_t addr, uint8_t &value)
@@ -40,11 +40,13 @@ private:
 	bool _hasCode = false;
 	vector<std::unique_ptr<vector<CodeInfo>>> _relativeCheatCodes;
 	vector<CodeInfo> _absoluteCheatCodes;
+	bool _pagesWithCodes[0x100] = {};
 
 	uint32_t DecodeValue(uint32_t code, uint32_t* bitIndexes, uint32_t bitCount);
 	CodeInfo GetGGCodeInfo(string ggCode);
 	CodeInfo GetPARCodeInfo(uint32_t parCode);
 	void AddCode(CodeInfo &code);
+	void UpdateDirectReadPages();
 	
 public:
 	CheatManager(std::shared_ptr<Console> console);
@@ -53,6 +55,13 @@ public:
 	void AddProActionRockyCode(uint32_t code);
 	void AddCustomCode(uint32_t address, uint8_t value, int32_t compareValue = -1, bool isRelativeAddress = true);
 	void ClearCodes();
+	void CopyCodes(CheatManager* source);
 
 	void ApplyCodes(uint16_t addr, uint8_t &value);
+
+	bool HasCodeInPage(uint8_t page)
+	{
+		//Absolute codes can apply to any page, depending on the current PRG banks
+		return _pagesWithCodes[page] || !_absoluteCheatCodes.empty();
+	}
 };
@@ -55,6 +55,13 @@ Console::~Console()
 {
 }
 
+void Console::ShareSettings(shared_ptr<Console> console)
+{
+	//Used by consoles that mirror another one (e.g run-ahead), settings changes must apply to both
+	_settings = console->_settings;
+	KeyManager::SetSettings(_settings.get());
+}
+
 void Console::Init(retro_environment_t retroEnv)
 {
 	_batteryManager.reset(new BatteryManager());
@@ -71,6 +78,11 @@ void Console::Init(retro_environment_t retroEnv)
 
 void Console::Release(bool forShutdown)
 {
+	if(_videoDecoder) {
+		//Make sure the decode thread is no longer using the PPU's buffers
+		_videoDecoder->StopThread();
+	}
+
 	if(_slave) {
 		_slave->Release(true);
 		_slave.reset();
@@ -219,6 +231,9 @@ bool Console::Initialize(VirtualFile &romFile, VirtualFile &patchFile, bool forP
 			SaveBatteries();
 		}
 
+		//The PPU and HD pack are about to be replaced
+		_videoDecoder->StopThread();
+
 		shared_ptr<HdPackData> originalHdPackData = _hdData;
 		LoadHdPack(romFile, patchFile);
 		if(patchFile.IsValid())
@@ -242,12 +257,14 @@ bool Console::Initialize(VirtualFile &romFile, VirtualFile &patchFile, bool forP
 
 			shared_ptr<BaseMapper> previousMapper = _mapper;
 			_mapper = mapper;
+			_saveStateManager->ClearStateHeaderCache();
 			_memoryManager.reset(new MemoryManager(shared_from_this()));
 			_cpu.reset(new CPU(shared_from_this()));
 			_apu.reset(new APU(shared_from_this()));
 
 			_mapper->SetConsole(shared_from_this());
 			_mapper->Initialize(romData);
+			_mapperRequiresCpuClock = _mapper->RequiresCpuClock();
 			if(!isDifferentGame && forPowerCycle) {
 				_mapper->CopyPrgChrRom(previousMapper);
 			}
@@ -349,7 +366,9 @@ bool Console::Initialize(VirtualFile &romFile, VirtualFile &patchFile, bool forP
 
 void Console::ProcessCpuClock()
 {
-	_mapper->ProcessCpuClock();
+	if(_mapperRequiresCpuClock) {
+		_mapper->ProcessCpuClock();
+	}
 	_apu->ProcessCpuClock();
 }
 
@@ -491,6 +510,18 @@ void Console::RunSingleFrame()
 	uint32_t lastFrameNumber = _ppu->GetFrameCount();
 	UpdateNesModel(true);
 
+	//Lazy PPU scheduling can't be used when the mapper watches the PPU bus, or when the PPU's timings are altered
+	_cpu->SetLazyPpu(
+		_settings->CheckFlag(EmulationFlags::LazyPpuScheduling) && !_mapper->RequiresPpuSync() &&
+		!_settings->CheckFlag(EmulationFlags::EnableOamDecay) &&
+		_settings->GetPpuExtraScanlinesBeforeNmi() == 0 && _settings->GetPpuExtraScanlinesAfterNmi() == 0
+	);
+
+	UpdateRenderSkip();
+	if(_slave) {
+		_slave->UpdateRenderSkip();
+	}
+
 	while(_ppu->GetFrameCount() == lastFrameNumber) {
 		_cpu->Exec();
 		if(_slave)
@@ -504,6 +535,12 @@ void Console::RunSingleFrame()
 	_apu->EndFrame();
 }
 
+void Console::UpdateRenderSkip()
+{
+	//The PPU doesn't need to output pixels when the frame won't be decoded, unless something reads the PPU's output buffer during the frame
+	_ppu->SetRenderSkip(_videoDecoder->IsDecodingDisabled() && !_hdPackBuilder && !_controlManager->HasLightGun());
+}
+
 void Console::RunSlaveCpu()
 {
 	int64_t cycleGap;
@@ -599,10 +636,65 @@ void Console::LoadState(istream &loadStream, uint32_t stateVersion)
 
 void Console::LoadState(uint8_t *buffer, uint32_t bufferSize)
 {
-	stringstream stream;
-	stream.write((char*)buffer, bufferSize);
-	stream.seekg(0, ios::beg);
-	LoadState(stream);
+	LoadState(buffer, buffer + bufferSize, SaveStateManager::FileFormatVersion);
+}
+
+bool Console::SaveState(uint8_t* &buffer, uint8_t* bufferEnd, uint64_t baseRamStamp)
+{
+	//Same as SaveState(ostream&), but writes directly to memory (returns false if the buffer is too small)
+	if(_initialized) {
+		_apu->EndFrame();
+
+		bool result = (
+			_cpu->SaveSnapshot(buffer, bufferEnd) &&
+			_ppu->SaveSnapshot(buffer, bufferEnd) &&
+			_memoryManager->SaveSnapshot(buffer, bufferEnd) &&
+			_apu->SaveSnapshot(buffer, bufferEnd) &&
+			_controlManager->SaveSnapshot(buffer, bufferEnd)
+		);
+
+		if(result) {
+			_mapper->SetIncrementalSave(baseRamStamp);
+			result = _mapper->SaveSnapshot(buffer, bufferEnd);
+			_mapper->SetIncrementalSave(0);
+		}
+
+		result = result && (_hdAudioDevice ? _hdAudioDevice->SaveSnapshot(buffer, bufferEnd) : Snapshotable::WriteEmptyBlock(buffer, bufferEnd));
+
+		if(result && _slave) {
+			result = _slave->SaveState(buffer, bufferEnd, baseRamStamp);
+		}
+		return result;
+	}
+	return true;
+}
+
+void Console::LoadState(uint8_t* &buffer, uint8_t* bufferEnd, uint32_t stateVersion, uint64_t incrementalRamStamp)
+{
+	//Same as LoadState(istream&, uint32_t), but reads directly from memory
+	if(_initialized) {
+		_apu->EndFrame();
+
+		_cpu->LoadSnapshot(buffer, bufferEnd, stateVersion);
+		_ppu->LoadSnapshot(buffer, bufferEnd, stateVersion);
+		_memoryManager->LoadSnapshot(buffer, bufferEnd, stateVersion);
+		_apu->LoadSnapshot(buffer, bufferEnd, stateVersion);
+		_controlManager->LoadSnapshot(buffer, bufferEnd, stateVersion);
+		_mapper->SetIncrementalLoad(incrementalRamStamp);
+		_mapper->LoadSnapshot(buffer, bufferEnd, stateVersion);
+		_mapper->SetIncrementalLoad(0);
+		if(_hdAudioDevice) {
+			_hdAudioDevice->LoadSnapshot(buffer, bufferEnd, stateVersion);
+		} else {
+			Snapshotable::SkipBlock(buffer, bufferEnd);
+		}
+
+		if(_slave) {
+			_slave->LoadState(buffer, bufferEnd, stateVersion, incrementalRamStamp);
+		}
+
+		UpdateNesModel(false);
+	}
 }
 
 void Console::SetNextFrameOverclockStatus(bool disabled)
@@ -647,7 +739,8 @@ void Console::LoadHdPack(VirtualFile &romFile, VirtualFile &patchFile)
 	_hdData.reset();
 	if(_settings->CheckFlag(EmulationFlags::UseHdPacks)) {
 		_hdData.reset(new HdPackData());
-		if(!HdPackLoader::LoadHdNesPack(romFile, *_hdData.get())) {
+		size_t tileCacheSize = (size_t)_settings->GetHdPackTileCacheSize() * 1024 * 1024;
+		if(!HdPackLoader::LoadHdNesPack(romFile, *_hdData.get(), tileCacheSize, _settings->CheckFlag(EmulationFlags::CompileHdPacks))) {
 			_hdData.reset();
 		} else {
 			auto result = _hdData->PatchesByHash.find(romFile.GetSha1Hash());
@@ -698,6 +791,8 @@ bool Console::UpdateHdPackMode()
 {
 	//Switch back and forth between HD PPU and regular PPU as needed
 
+	_videoDecoder->StopThread();
+
 	VirtualFile romFile = _romFilepath;
 	VirtualFile patchFile = _patchFilename;
 	LoadHdPack(romFile, patchFile);
@@ -72,18 +72,21 @@ private:
 	string _patchFilename;
 
 	bool _disableOcNextFrame = false;
+	bool _mapperRequiresCpuClock = false;
 
 	bool _initialized = false;
 
 	void LoadHdPack(VirtualFile &romFile, VirtualFile &patchFile);
 
 	void UpdateNesModel(bool sendNotification);
+	void UpdateRenderSkip();
 
 public:
 	Console(std::shared_ptr<Console> master = nullptr, EmulationSettings* initialSettings = nullptr);
 	~Console();
 
 	void Init(retro_environment_t retroEnv);
+	void ShareSettings(std::shared_ptr<Console> console);
 	void Release(bool forShutdown);
 
 	std::shared_ptr<BatteryManager> GetBatteryManager();
@@ -140,6 +143,10 @@ public:
 	void LoadState(istream &loadStream);
 	void LoadState(istream &loadStream, uint32_t stateVersion);
 	void LoadState(uint8_t *buffer, uint32_t bufferSize);
+	//When a base RAM stamp is given (see BaseMapper::SetIncrementalSave), the mapper RAM pages not modified since then are only referenced
+	bool SaveState(uint8_t* &buffer, uint8_t* bufferEnd, uint64_t baseRamStamp = 0);
+	//When a RAM stamp is given (see BaseMapper::GetRamStamp), only the mapper RAM pages modified since the state was saved are restored
+	void LoadState(uint8_t* &buffer, uint8_t* bufferEnd, uint32_t stateVersion, uint64_t incrementalRamStamp = 0);
 
 	VirtualFile GetRomPath();
 	VirtualFile GetPatchFile();
@@ -205,6 +205,17 @@ bool ControlManager::HasKeyboard()
 	return expDevice && expDevice->IsKeyboard();
 }
 
+bool ControlManager::HasLightGun()
+{
+	//Light guns read the PPU's output buffer to detect light
+	for(shared_ptr<BaseControlDevice> &device : _controlDevices) {
+		if(std::dynamic_pointer_cast<Zapper>(device) || std::dynamic_pointer_cast<BandaiHyperShot>(device)) {
+			return true;
+		}
+	}
+	return false;
+}
+
 uint8_t ControlManager::GetOpenBusMask(uint8_t port)
 {
 	//"In the NES and Famicom, the top three (or five) bits are not driven, and so retain the bits of the previous byte on the bus. 
@@ -64,6 +64,7 @@ public:
 	std::shared_ptr<BaseControlDevice> GetControlDevice(uint8_t port);
 	vector<std::shared_ptr<BaseControlDevice>> GetControlDevices();
 	bool HasKeyboard();
+	bool HasLightGun();
 	
 	static std::shared_ptr<BaseControlDevice> CreateControllerDevice(ControllerType type, uint8_t port, std::shared_ptr<Console> console);
 	static std::shared_ptr<BaseControlDevice> CreateExpansionDevice(ExpansionPortDevice type, std::shared_ptr<Console> console);
@@ -6,6 +6,10 @@
 #include "PPU.h"
 #include "Console.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#include <immintrin.h>
+	#define DEFAULT_FILTER_AVX2
+#endif
 
 DefaultVideoFilter::DefaultVideoFilter(shared_ptr<Console> console) : BaseVideoFilter(console)
 {
@@ -44,15 +48,31 @@ FrameInfo DefaultVideoFilter::GetFrameInfo()
 void DefaultVideoFilter::OnBeforeApplyFilter()
 {
 	PictureSettings currentSettings = _console->GetSettings()->GetPictureSettings();
+	uint32_t* originalPalette = _console->GetSettings()->GetRgbPalette();
+
+	bool paletteChanged = (
+		!_paletteValid || memcmp(_sourcePalette, originalPalette, sizeof(_sourcePalette)) != 0 ||
+		_pictureSettings.Hue != currentSettings.Hue || _pictureSettings.Saturation != currentSettings.Saturation ||
+		_pictureSettings.Brightness != currentSettings.Brightness || _pictureSettings.Contrast != currentSettings.Contrast
+	);
+
 	if(_pictureSettings.Hue != currentSettings.Hue || _pictureSettings.Saturation != currentSettings.Saturation) {
 		InitConversionMatrix(currentSettings.Hue, currentSettings.Saturation);
 	}
 	_pictureSettings = currentSettings;
+
+	if(!paletteChanged) {
+		return;
+	}
+
+	memcpy(_sourcePalette, originalPalette, sizeof(_sourcePalette));
+	_paletteValid = true;
+	_scanlinePaletteValid = false;
+
 	_needToProcess = _pictureSettings.Hue != 0 || _pictureSettings.Saturation != 0 || _pictureSettings.Brightness || _pictureSettings.Contrast;
 
 	if(_needToProcess) {
 		double y, i, q;
-		uint32_t* originalPalette = _console->GetSettings()->GetRgbPalette();
 
 		for(int pal = 0; pal < 512; pal++) {
 			uint32_t pixelOutput = originalPalette[pal];
@@ -73,7 +93,40 @@ void DefaultVideoFilter::OnBeforeApplyFilter()
 			_calculatedPalette[pal] = 0xFF000000 | (r << 16) | (g << 8) | b;
 		}
 	} else {
-		memcpy(_calculatedPalette, _console->GetSettings()->GetRgbPalette(), sizeof(_calculatedPalette));
+		memcpy(_calculatedPalette, originalPalette, sizeof(_calculatedPalette));
+	}
+}
+
+#ifdef DEFAULT_FILTER_AVX2
+__attribute__((target("avx2")))
+static void DecodeRowAvx2(uint16_t *ppuRow, uint32_t *output, uint32_t pixelCount, uint32_t *palette)
+{
+	//Palette lookup for 8 pixels at once (PPU pixels are 9-bit indexes into the 512-entry palette)
+	uint32_t i = 0;
+	for(; i + 8 <= pixelCount; i += 8) {
+		__m256i indexes = _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i*)(ppuRow + i)));
+		_mm256_storeu_si256((__m256i*)(output + i), _mm256_i32gather_epi32((const int*)palette, indexes, 4));
+	}
+	for(; i < pixelCount; i++) {
+		output[i] = palette[ppuRow[i]];
+	}
+}
+#endif
+
+void DefaultVideoFilter::DecodeRow(uint16_t *ppuRow, uint32_t *output, uint32_t pixelCount, uint32_t *palette)
+{
+	//SSE2 and NEON have no gather instruction, and their shuffle-based lookups only cover 16-64 byte tables (not 512 32-bit entries),
+	//so they use the scalar loop below (which the compiler unrolls) - only AVX2 is fast enough to be worth a separate path
+#ifdef DEFAULT_FILTER_AVX2
+	static const bool useAvx2 = __builtin_cpu_supports("avx2");
+	if(useAvx2) {
+		DecodeRowAvx2(ppuRow, output, pixelCount, palette);
+		return;
+	}
+#endif
+
+	for(uint32_t i = 0; i < pixelCount; i++) {
+		output[i] = palette[ppuRow[i]];
 	}
 }
 
@@ -81,20 +134,25 @@ void DefaultVideoFilter::DecodePpuBuffer(uint16_t *ppuOutputBuffer, uint32_t* ou
 {
 	uint32_t* out = outputBuffer;
 	OverscanDimensions overscan = GetOverscan();
-	uint8_t scanlineIntensity = (uint8_t)((1.0 - _console->GetSettings()->GetPictureSettings().ScanlineIntensity) * 255);
-	for(uint32_t i = overscan.Top, iMax = 240 - overscan.Bottom; i < iMax; i++) {
-		if(displayScanlines && (i + overscan.Top) % 2 == 0) {
-			for(uint32_t j = overscan.Left, jMax = 256 - overscan.Right; j < jMax; j++) {
-				*out = ApplyScanlineEffect(ppuOutputBuffer[i * 256 + j], scanlineIntensity);
-				out++;
-			}
-		} else {
-			for(uint32_t j = overscan.Left, jMax = 256 - overscan.Right; j < jMax; j++) {
-				*out = _calculatedPalette[ppuOutputBuffer[i * 256 + j]];
-				out++;
+	uint32_t rowWidth = overscan.GetScreenWidth();
+
+	if(displayScanlines) {
+		//Darken the palette once rather than each pixel of every other line
+		uint8_t scanlineIntensity = (uint8_t)((1.0 - _pictureSettings.ScanlineIntensity) * 255);
+		if(!_scanlinePaletteValid || _scanlineIntensity != scanlineIntensity) {
+			for(int i = 0; i < 512; i++) {
+				_scanlinePalette[i] = ApplyScanlineEffect(i, scanlineIntensity);
 			}
+			_scanlineIntensity = scanlineIntensity;
+			_scanlinePaletteValid = true;
 		}
 	}
+
+	for(uint32_t i = overscan.Top, iMax = 240 - overscan.Bottom; i < iMax; i++) {
+		uint32_t* palette = (displayScanlines && (i + overscan.Top) % 2 == 0) ? _scanlinePalette : _calculatedPalette;
+		DecodeRow(ppuOutputBuffer + i * 256 + overscan.Left, out, rowWidth, palette);
+		out += rowWidth;
+	}
 }
 
 void DefaultVideoFilter::ApplyFilter(uint16_t *ppuOutputBuffer)
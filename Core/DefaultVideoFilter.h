@@ -8,14 +8,23 @@ class DefaultVideoFilter : public BaseVideoFilter
 private:
 	double _yiqToRgbMatrix[6];
 	uint32_t _calculatedPalette[512];
+	uint32_t _scanlinePalette[512];
 	PictureSettings _pictureSettings;
 	bool _needToProcess = false;
 
+	//Palette the lookup tables were built from, they are only rebuilt when it or the picture settings change
+	uint32_t _sourcePalette[512] = {};
+	bool _paletteValid = false;
+	bool _scanlinePaletteValid = false;
+	uint8_t _scanlineIntensity = 0;
+
 	void InitConversionMatrix(double hueShift, double saturationShift);
 
 	void RgbToYiq(double r, double g, double b, double &y, double &i, double &q);
 	void YiqToRgb(double y, double i, double q, double &r, double &g, double &b);
 
+	static void DecodeRow(uint16_t *ppuRow, uint32_t *output, uint32_t pixelCount, uint32_t *palette);
+
 protected:
 	void DecodePpuBuffer(uint16_t *ppuOutputBuffer, uint32_t* outputBuffer, bool displayScanlines);
 	uint32_t ApplyScanlineEffect(uint16_t ppuPixel, uint8_t scanlineIntensity);
@@ -86,6 +86,8 @@ void DeltaModulationChannel::SetDmcReadBuffer(uint8_t value)
 				_console->GetCpu()->SetIrqSource(IRQSource::DMC);
 			}
 		}
+
+		_console->GetApu()->InvalidateNextRunCycle();
 	}
 }
 
@@ -163,6 +165,7 @@ void DeltaModulationChannel::WriteRAM(uint16_t addr, uint8_t value)
 			if(!_irqEnabled) {
 				_console->GetCpu()->ClearIrqSource(IRQSource::DMC);
 			}
+			_console->GetApu()->InvalidateNextRunCycle();
 			break;
 
 		case 1: {		//4011
@@ -231,6 +234,24 @@ bool DeltaModulationChannel::NeedToRun()
 	return _needToRun;
 }
 
+uint32_t DeltaModulationChannel::GetCyclesToNextEvent()
+{
+	if(_needInit > 0) {
+		//NeedToRun must be called on every cycle until the DMA starts
+		return 0;
+	}
+
+	uint32_t cycles = UINT32_MAX;
+	if(_needToRun) {
+		//The DMA can only start when the timer clocks the output unit, the cycles in between can be run in a single batch
+		cycles = _timer + 1;
+	}
+	if(_irqEnabled && _bytesRemaining > 0) {
+		cycles = std::min(cycles, (uint32_t)(_bitsRemaining + (_bytesRemaining - 1) * 8) * _period);
+	}
+	return cycles;
+}
+
 ApuDmcState DeltaModulationChannel::GetState()
 {
 	ApuDmcState state;
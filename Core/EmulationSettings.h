@@ -62,6 +62,7 @@ enum EmulationFlags : uint64_t
 	Rewind =  0x1000000000,
 	Turbo = 0x2000000000,
 	InBackground = 0x4000000000,
+	LazyPpuScheduling = 0x8000000000,
 	
 	DisplayMovieIcons = 0x10000000000,
 	HidePauseOverlay = 0x20000000000,
@@ -74,6 +75,8 @@ enum EmulationFlags : uint64_t
 	EnablePpu2000ScrollGlitch = 0x200000000000,
 
 	ConfirmExitResetPower = 0x400000000000,
+	ThreadedVideoFilter = 0x800000000000,
+	CompileHdPacks = 0x1000000000000,
 
 	IntegerFpsMode = 0x2000000000000,
 
@@ -477,6 +480,8 @@ private:
 	bool _backgroundEnabled = true;
 	bool _spritesEnabled = true;
 	uint32_t _screenRotation = 0;
+	uint32_t _videoFilterThreadCount = 0;
+	uint32_t _hdPackTileCacheSize = 0;
 
 	ConsoleType _consoleType = ConsoleType::Nes;
 	ExpansionPortDevice _expansionDevice = ExpansionPortDevice::None;
@@ -877,6 +882,28 @@ public:
 		return _videoScale;
 	}
 	
+	void SetVideoFilterThreadCount(uint32_t threadCount)
+	{
+		_videoFilterThreadCount = threadCount;
+	}
+
+	//0 = one thread per core
+	uint32_t GetVideoFilterThreadCount()
+	{
+		return _videoFilterThreadCount;
+	}
+
+	void SetHdPackTileCacheSize(uint32_t sizeInMb)
+	{
+		_hdPackTileCacheSize = sizeInMb;
+	}
+
+	//In MB, 0 = decode all of the HD pack's tiles when it is loaded (takes effect the next time the pack is loaded)
+	uint32_t GetHdPackTileCacheSize()
+	{
+		return _hdPackTileCacheSize;
+	}
+
 	void SetScreenRotation(uint32_t angle)
 	{
 		_screenRotation = angle;
@@ -179,6 +179,15 @@ uint8_t FDS::ReadRAM(uint16_t addr)
 	return BaseMapper::ReadRAM(addr);
 }
 
+uint8_t* FDS::GetDirectReadPage(uint8_t page)
+{
+	//ReadRAM needs to see reads to $E18C and $E445 (used to detect the game starting & for auto disk insertion)
+	if(page == 0xE1 || page == 0xE4) {
+		return nullptr;
+	}
+	return BaseMapper::GetDirectReadPage(page);
+}
+
 void FDS::ProcessAutoDiskInsert()
 {
 	if(IsAutoInsertDiskEnabled()) {
@@ -100,6 +100,7 @@ protected:
 
 	void ClockIrq();
 	
+	bool RequiresCpuClock() override { return true; }
 	void ProcessCpuClock() override;
 	void UpdateCrc(uint8_t value);
 
@@ -107,6 +108,7 @@ protected:
 	uint8_t ReadRegister(uint16_t addr) override;
 
 	uint8_t ReadRAM(uint16_t addr) override;
+	uint8_t* GetDirectReadPage(uint8_t page) override;
 
 	void StreamState(bool saving) override;
 
@@ -43,6 +43,7 @@ private:
 protected:
 	uint16_t GetPRGPageSize() override { return 0x2000; }
 	uint16_t GetCHRPageSize() override { return 0x0400; }
+	bool RequiresPpuSync() override { return true; }
 	
 	uint32_t GetChrRamSize() override { return 0x40000; } //Some games have up to 256kb of CHR RAM (only used for iNES 1.0 files w/ no DB entry)
 	uint16_t GetChrRamPageSize() override { return 0x400; }
@@ -346,6 +347,8 @@ protected:
 	}
 
 public:
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		if(_irqDelay > 0) {
@@ -46,6 +46,8 @@ protected:
 		Stream(_irqCounter, _irqEnabled, _ffeAltMode);
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		if(_irqEnabled) {
@@ -3,6 +3,8 @@
 #include <unordered_set>
 #include "PPU.h"
 #include "../Utilities/HexUtilities.h"
+#include "../Utilities/MemoryMappedFile.h"
+#include "HdTileBitmapCache.h"
 
 struct HdTileKey
 {
@@ -13,7 +15,7 @@ struct HdTileKey
 	int32_t TileIndex;
 	bool IsChrRamTile = false;
 
-	HdTileKey GetKey(bool defaultKey)
+	HdTileKey GetKey(bool defaultKey) const
 	{
 		if(defaultKey) {
 			HdTileKey copy = *this;
@@ -24,16 +26,24 @@ struct HdTileKey
 		}
 	}
 
-	uint32_t GetHashCode() const
+	//Hash of the tile itself, without its palette (a tile and its default palette version have the same tile hash)
+	uint32_t GetTileHash() const
 	{
 		if(IsChrRamTile) {
-			return CalculateHash((uint8_t*)&PaletteColors, 20);
+			uint64_t low, high;
+			memcpy(&low, TileData, sizeof(low));
+			memcpy(&high, TileData + 8, sizeof(high));
+			return (uint32_t)MixHash(low ^ MixHash(high));
 		} else {
-			uint64_t key = TileIndex | ((uint64_t)PaletteColors << 32);
-			return CalculateHash((uint8_t*)&key, sizeof(key));
+			return (uint32_t)MixHash((uint32_t)TileIndex);
 		}
 	}
 
+	uint32_t GetHashCode() const
+	{
+		return (uint32_t)MixHash(GetTileHash() | ((uint64_t)PaletteColors << 32));
+	}
+
 	size_t operator() (const HdTileKey &tile) const {
 		return tile.GetHashCode();
 	}
@@ -47,18 +57,15 @@ struct HdTileKey
 		}
 	}
 
-	uint32_t CalculateHash(const uint8_t* key, size_t len) const
+	static uint64_t MixHash(uint64_t value)
 	{
-		uint32_t result = 0;
-		for(size_t i = 0; i < len; i += 4) {
-			uint32_t chunk;
-			memcpy(&chunk, key, sizeof(uint32_t));
-
-			result += chunk;
-			result = (result << 2) | (result >> 30);
-			key += 4;
-		}
-		return result;
+		//MurmurHash3's 64-bit finalizer
+		value ^= value >> 33;
+		value *= 0xFF51AFD7ED558CCDULL;
+		value ^= value >> 33;
+		value *= 0xC4CEB9FE1A85EC53ULL;
+		value ^= value >> 33;
+		return value;
 	}
 
 	bool IsSpriteTile()
@@ -151,9 +158,13 @@ struct HdPackCondition
 
 	virtual ~HdPackCondition() { }
 
-	void ClearCache()
+	//Cached conditions don't depend on the pixel being drawn, evaluate them once per frame so the rendering threads only read the result
+	void UpdateCache(HdScreenInfo *screenInfo)
 	{
 		_resultCache = -1;
+		if(_useCache) {
+			CheckCondition(screenInfo, 0, 0, nullptr);
+		}
 	}
 
 	bool CheckCondition(HdScreenInfo *screenInfo, int x, int y, HdPpuTileInfo* tile)
@@ -192,11 +203,22 @@ struct HdPackTileInfo : public HdTileKey
 	bool TransparencyRequired;
 	bool IsFullyTransparent;
 	vector<uint32_t> HdTileData;
+	uint32_t* MappedTileData = nullptr; //Set instead of HdTileData when loaded from a compiled pack
+	HdTileBitmapCache* BitmapCache = nullptr; //Set instead of HdTileData when the tile is decoded on demand
+	uint32_t CacheIndex = 0;
 	uint32_t ChrBankId;
 
 	vector<HdPackCondition*> Conditions;
 	bool ForceDisableCache;
 
+	uint32_t* GetTileData()
+	{
+		if(BitmapCache) {
+			return BitmapCache->GetTileData(CacheIndex);
+		}
+		return MappedTileData ? MappedTileData : HdTileData.data();
+	}
+
 	bool MatchesCondition(HdScreenInfo *hdScreenInfo, int x, int y, HdPpuTileInfo* tile)
 	{
 		for(HdPackCondition* condition : Conditions) {
@@ -290,6 +312,112 @@ struct HdPackTileInfo : public HdTileKey
 	}
 };
 
+//Flat open-addressing (linear probing) table of the pack's tiles, by tile key
+//A key and its default palette version share the same tile hash, so a single probe sequence finds either one
+class HdTileIndex
+{
+private:
+	static constexpr uint32_t DefaultPalette = 0xFFFFFFFF;
+
+	struct Slot
+	{
+		uint32_t TileHash;
+		uint32_t PaletteColors;
+		uint32_t Entry; //Index in _entries + 1, 0 = empty slot
+	};
+
+	struct Entry
+	{
+		HdTileKey Key;
+		vector<HdPackTileInfo*> Tiles;
+	};
+
+	vector<Slot> _slots;
+	vector<Entry> _entries;
+	uint32_t _mask = 0;
+
+	void InsertSlot(uint32_t entryIndex)
+	{
+		HdTileKey &key = _entries[entryIndex].Key;
+		uint32_t tileHash = key.GetTileHash();
+		uint32_t pos = tileHash & _mask;
+		while(_slots[pos].Entry) {
+			pos = (pos + 1) & _mask;
+		}
+		_slots[pos] = { tileHash, key.PaletteColors, entryIndex + 1 };
+	}
+
+public:
+	void Add(const HdTileKey &key, HdPackTileInfo* tile)
+	{
+		vector<HdPackTileInfo*>* tiles = Find(key);
+		if(!tiles) {
+			_entries.push_back({ key, {} });
+			if(_entries.size() * 2 > _slots.size()) {
+				//Keep the table at most half full, so probe sequences stay short
+				_slots.assign(std::max<size_t>(_slots.size() * 2, 64), Slot { 0, 0, 0 });
+				_mask = (uint32_t)_slots.size() - 1;
+				for(uint32_t i = 0; i < _entries.size(); i++) {
+					InsertSlot(i);
+				}
+			} else {
+				InsertSlot((uint32_t)_entries.size() - 1);
+			}
+			tiles = &_entries.back().Tiles;
+		}
+		tiles->push_back(tile);
+	}
+
+	//Returns the tiles for this exact key, or nullptr
+	vector<HdPackTileInfo*>* Find(const HdTileKey &key)
+	{
+		if(_entries.empty()) {
+			return nullptr;
+		}
+
+		uint32_t tileHash = key.GetTileHash();
+		for(uint32_t pos = tileHash & _mask; _slots[pos].Entry; pos = (pos + 1) & _mask) {
+			Slot &slot = _slots[pos];
+			if(slot.TileHash == tileHash && slot.PaletteColors == key.PaletteColors && key == _entries[slot.Entry - 1].Key) {
+				return &_entries[slot.Entry - 1].Tiles;
+			}
+		}
+		return nullptr;
+	}
+
+	//Returns the tiles for this exact key, otherwise the ones for its default palette version (or nullptr)
+	vector<HdPackTileInfo*>* FindMatch(const HdTileKey &key)
+	{
+		if(_entries.empty()) {
+			return nullptr;
+		}
+
+		vector<HdPackTileInfo*>* defaultTiles = nullptr;
+		uint32_t tileHash = key.GetTileHash();
+		for(uint32_t pos = tileHash & _mask; _slots[pos].Entry; pos = (pos + 1) & _mask) {
+			Slot &slot = _slots[pos];
+			if(slot.TileHash != tileHash) {
+				continue;
+			}
+
+			Entry &entry = _entries[slot.Entry - 1];
+			if(slot.PaletteColors == key.PaletteColors) {
+				if(key == entry.Key) {
+					return &entry.Tiles;
+				}
+			} else if(slot.PaletteColors == DefaultPalette && !defaultTiles && key.GetKey(true) == entry.Key) {
+				defaultTiles = &entry.Tiles;
+			}
+		}
+		return defaultTiles;
+	}
+
+	size_t GetKeyCount()
+	{
+		return _entries.size();
+	}
+};
+
 struct HdPackBitmapInfo
 {
 	vector<uint32_t> PixelData;
@@ -304,6 +432,7 @@ struct HdBackgroundFileData
 	uint32_t Height;
 
 	vector<uint32_t> PixelData;
+	uint32_t* MappedPixelData = nullptr; //Set instead of PixelData when loaded from a compiled pack
 };
 
 struct HdBackgroundInfo
@@ -320,7 +449,7 @@ struct HdBackgroundInfo
 
 	uint32_t* data()
 	{
-		return Data->PixelData.data();
+		return Data->MappedPixelData ? Data->MappedPixelData : Data->PixelData.data();
 	}
 
 	string ToString()
@@ -353,7 +482,9 @@ struct HdPackData
 	vector<unique_ptr<HdPackTileInfo>> Tiles;
 	vector<unique_ptr<HdPackCondition>> Conditions;
 	std::unordered_set<uint32_t> WatchedMemoryAddresses;
-	std::unordered_map<HdTileKey, vector<HdPackTileInfo*>> TileByKey;
+	HdTileIndex TileByKey;
+	unique_ptr<MemoryMappedFile> CompiledPack; //Holds the tile and background pixels when loaded from a compiled pack
+	unique_ptr<HdTileBitmapCache> BitmapCache; //Holds the tile pixels when they are decoded on demand
 	std::unordered_map<string, string> PatchesByHash;
 	std::unordered_map<int, string> BgmFilesById;
 	std::unordered_map<int, string> SfxFilesById;
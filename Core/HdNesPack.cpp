@@ -84,7 +84,7 @@ void HdNesPack::DrawTile(HdPpuTileInfo &tileInfo, HdPackTileInfo &hdPackTileInfo
 	}
 
 	uint32_t scale = GetScale();
-	uint32_t *bitmapData = hdPackTileInfo.HdTileData.data();
+	uint32_t *bitmapData = hdPackTileInfo.GetTileData();
 	uint32_t tileWidth = 8 * scale;
 	uint8_t tileOffsetX = tileInfo.HorizontalMirroring ? 7 - tileInfo.OffsetX : tileInfo.OffsetX;
 	uint32_t bitmapOffset = (tileInfo.OffsetY * scale) * tileWidth + tileOffsetX * scale;
@@ -136,23 +136,46 @@ void HdNesPack::DrawTile(HdPpuTileInfo &tileInfo, HdPackTileInfo &hdPackTileInfo
 	}
 }
 
+void HdNesPack::DrawTileSpan(HdPpuTileInfo &tileInfo, HdPackTileInfo &hdPackTileInfo, uint32_t pixelCount, uint32_t *outputBuffer, uint32_t screenWidth)
+{
+	//Opaque tile at full brightness: each output row is a straight (or mirrored) copy of part of a bitmap row
+	uint32_t scale = GetScale();
+	uint32_t tileWidth = 8 * scale;
+	uint32_t spanWidth = pixelCount * scale;
+	uint32_t *bitmapData = hdPackTileInfo.GetTileData();
+
+	for(uint32_t y = 0; y < scale; y++) {
+		uint32_t bitmapRow = tileInfo.OffsetY * scale + (tileInfo.VerticalMirroring ? scale - 1 - y : y);
+		uint32_t *src = bitmapData + bitmapRow * tileWidth;
+		if(tileInfo.HorizontalMirroring) {
+			src += (8 - tileInfo.OffsetX) * scale - 1;
+			for(uint32_t x = 0; x < spanWidth; x++) {
+				outputBuffer[x] = *(src - x);
+			}
+		} else {
+			memcpy(outputBuffer, src + tileInfo.OffsetX * scale, spanWidth * sizeof(uint32_t));
+		}
+		outputBuffer += screenWidth;
+	}
+}
+
 uint32_t HdNesPack::GetScale()
 {
 	return _hdData->Scale;
 }
 
-void HdNesPack::OnLineStart(HdPpuPixelInfo &lineFirstPixel, uint8_t y)
+void HdNesPack::OnLineStart(HdLineState &state, HdPpuPixelInfo &lineFirstPixel, uint8_t y)
 {
-	_scrollX = ((lineFirstPixel.TmpVideoRamAddr & 0x1F) << 3) | lineFirstPixel.XScroll | ((lineFirstPixel.TmpVideoRamAddr & 0x400) ? 0x100 : 0);
-	_useCachedTile = false;
+	state.ScrollX = ((lineFirstPixel.TmpVideoRamAddr & 0x1F) << 3) | lineFirstPixel.XScroll | ((lineFirstPixel.TmpVideoRamAddr & 0x400) ? 0x100 : 0);
+	state.UseCachedTile = false;
 
 	int32_t scrollY = (((lineFirstPixel.TmpVideoRamAddr & 0x3E0) >> 2) | ((lineFirstPixel.TmpVideoRamAddr & 0x7000) >> 12)) + ((lineFirstPixel.TmpVideoRamAddr & 0x800) ? 240 : 0);
 	
 	for(int layer = 0; layer < 4; layer++) {
 		for(int i = 0; i < _activeBgCount[layer]; i++) {
-			HdBgConfig& cfg = _bgConfig[layer * HdNesPack::PriorityLevelsPerLayer + i];
+			HdBgConfig& cfg = state.BgConfig[layer * HdNesPack::PriorityLevelsPerLayer + i];
 			HdBackgroundInfo& bgInfo = _hdData->Backgrounds[cfg.BackgroundIndex];
-			cfg.BgScrollX = (int32_t)(_scrollX * bgInfo.HorizontalScrollRatio);
+			cfg.BgScrollX = (int32_t)(state.ScrollX * bgInfo.HorizontalScrollRatio);
 			cfg.BgScrollY = (int32_t)(scrollY * bgInfo.VerticalScrollRatio);
 			if(y >= -cfg.BgScrollY && (y + bgInfo.Top + cfg.BgScrollY + 1) * _hdData->Scale <= bgInfo.Data->Height) {
 				cfg.BgMinX = -cfg.BgScrollX;
@@ -192,10 +215,18 @@ void HdNesPack::OnBeforeApplyFilter()
 	_palette = _hdData->Palette.size() == 0x40 ? _hdData->Palette.data() : _settings->GetRgbPalette();
 	_cacheEnabled = (_hdData->OptionFlags & (int)HdPackOptions::DisableCache) == 0;
 
+	if(_hdData->BitmapCache) {
+		_hdData->BitmapCache->OnFrameStart();
+	}
+
 	if(_hdData->OptionFlags & (int)HdPackOptions::NoSpriteLimit) {
 		_settings->SetFlags(EmulationFlags::RemoveSpriteLimit | EmulationFlags::AdaptiveSpriteLimit);
 	}
 
+	for(unique_ptr<HdPackCondition> &condition : _hdData->Conditions) {
+		condition->UpdateCache(_hdScreenInfo);
+	}
+
 	for(int layer = 0; layer < 4; layer++) {
 		uint32_t activeCount = 0;
 		for(int i = 0; i < HdNesPack::PriorityLevelsPerLayer; i++) {
@@ -207,30 +238,26 @@ void HdNesPack::OnBeforeApplyFilter()
 		}
 		_activeBgCount[layer] = activeCount;
 	}
-
-	for(unique_ptr<HdPackCondition> &condition : _hdData->Conditions) {
-		condition->ClearCache();
-	}
 }
 
-HdPackTileInfo* HdNesPack::GetCachedMatchingTile(uint32_t x, uint32_t y, HdPpuTileInfo* tile)
+HdPackTileInfo* HdNesPack::GetCachedMatchingTile(HdLineState &state, uint32_t x, uint32_t y, HdPpuTileInfo* tile)
 {
-	if(((_scrollX + x) & 0x07) == 0) {
-		_useCachedTile = false;
+	if(((state.ScrollX + x) & 0x07) == 0) {
+		state.UseCachedTile = false;
 	}
 
 	bool disableCache = false;
 	HdPackTileInfo* hdPackTileInfo;
-	if(_useCachedTile) {
-		hdPackTileInfo = _cachedTile;
+	if(state.UseCachedTile) {
+		hdPackTileInfo = state.CachedTile;
 	} else {
 		hdPackTileInfo = GetMatchingTile(x, y, tile, &disableCache);
 
 		if(!disableCache && _cacheEnabled) {
 			//Use this tile for the next 8 horizontal pixels
 			//Disable cache if a sprite condition is used, because sprites are not on a 8x8 grid
-			_cachedTile = hdPackTileInfo;
-			_useCachedTile = true;
+			state.CachedTile = hdPackTileInfo;
+			state.UseCachedTile = true;
 		}
 	}
 	return hdPackTileInfo;
@@ -238,13 +265,9 @@ HdPackTileInfo* HdNesPack::GetCachedMatchingTile(uint32_t x, uint32_t y, HdPpuTi
 
 HdPackTileInfo* HdNesPack::GetMatchingTile(uint32_t x, uint32_t y, HdPpuTileInfo* tile, bool* disableCache)
 {
-	auto hdTile = _hdData->TileByKey.find(*tile);
-	if(hdTile == _hdData->TileByKey.end()) {
-		hdTile = _hdData->TileByKey.find(tile->GetKey(true));
-	}
-
-	if(hdTile != _hdData->TileByKey.end()) {
-		for(HdPackTileInfo* hdPackTile : hdTile->second) {
+	vector<HdPackTileInfo*>* hdTiles = _hdData->TileByKey.FindMatch(*tile);
+	if(hdTiles) {
+		for(HdPackTileInfo* hdPackTile : *hdTiles) {
 			if(disableCache != nullptr && hdPackTile->ForceDisableCache) {
 				*disableCache = true;
 			}
@@ -258,9 +281,26 @@ HdPackTileInfo* HdNesPack::GetMatchingTile(uint32_t x, uint32_t y, HdPpuTileInfo
 	return nullptr;
 }
 
-bool HdNesPack::DrawBackgroundLayer(uint8_t priority, uint32_t x, uint32_t y, uint32_t* outputBuffer, uint32_t screenWidth)
+bool HdNesPack::IsBgTileCovered(HdLineState &state, uint32_t x, HdPpuPixelInfo &pixelInfo)
+{
+	if(pixelInfo.SpriteCount > 0) {
+		return true;
+	}
+
+	for(int layer = 2; layer < 4; layer++) {
+		for(int i = 0; i < _activeBgCount[layer]; i++) {
+			HdBgConfig &bgConfig = state.BgConfig[layer * HdNesPack::PriorityLevelsPerLayer + i];
+			if((int32_t)x >= bgConfig.BgMinX && (int32_t)x <= bgConfig.BgMaxX) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool HdNesPack::DrawBackgroundLayer(HdLineState &state, uint8_t priority, uint32_t x, uint32_t y, uint32_t* outputBuffer, uint32_t screenWidth)
 {
-	HdBgConfig bgConfig = _bgConfig[(int)priority];
+	HdBgConfig &bgConfig = state.BgConfig[(int)priority];
 	if((int32_t)x >= bgConfig.BgMinX && (int32_t)x <= bgConfig.BgMaxX) {
 		HdBackgroundInfo& bgInfo = _hdData->Backgrounds[bgConfig.BackgroundIndex];
 		DrawCustomBackground(bgInfo, outputBuffer, x + bgConfig.BgScrollX, y + bgConfig.BgScrollY, _hdData->Scale, screenWidth);
@@ -269,16 +309,12 @@ bool HdNesPack::DrawBackgroundLayer(uint8_t priority, uint32_t x, uint32_t y, ui
 	return false;
 }
 
-void HdNesPack::GetPixels(uint32_t x, uint32_t y, HdPpuPixelInfo &pixelInfo, uint32_t *outputBuffer, uint32_t screenWidth)
+void HdNesPack::GetPixels(HdLineState &state, HdPackTileInfo* hdPackTileInfo, uint32_t x, uint32_t y, HdPpuPixelInfo &pixelInfo, uint32_t *outputBuffer, uint32_t screenWidth)
 {
-	HdPackTileInfo *hdPackTileInfo = nullptr;
 	HdPackTileInfo *hdPackSpriteInfo = nullptr;
 
 	bool hasSprite = pixelInfo.SpriteCount > 0;
 	bool renderOriginalTiles = ((_hdData->OptionFlags & (int)HdPackOptions::DontRenderOriginalTiles) == 0);
-	if(pixelInfo.Tile.TileIndex != HdPpuTileInfo::NoTile) {
-		hdPackTileInfo = GetCachedMatchingTile(x, y, &pixelInfo.Tile);
-	}
 
 	int lowestBgSprite = 999;
 	
@@ -286,7 +322,7 @@ void HdNesPack::GetPixels(uint32_t x, uint32_t y, HdPpuPixelInfo &pixelInfo, uin
 
 	bool hasBackground = false;
 	for(int i = 0; i < _activeBgCount[0]; i++) {
-		hasBackground |= DrawBackgroundLayer(HdNesPack::BehindBgSpritesPriority+i, x, y, outputBuffer, screenWidth);
+		hasBackground |= DrawBackgroundLayer(state, HdNesPack::BehindBgSpritesPriority+i, x, y, outputBuffer, screenWidth);
 	}
 
 	if(hasSprite) {
@@ -307,7 +343,7 @@ void HdNesPack::GetPixels(uint32_t x, uint32_t y, HdPpuPixelInfo &pixelInfo, uin
 	}
 	
 	for(int i = 0; i < _activeBgCount[1]; i++) {
-		hasBackground |= DrawBackgroundLayer(HdNesPack::BehindBgPriority+i, x, y, outputBuffer, screenWidth);
+		hasBackground |= DrawBackgroundLayer(state, HdNesPack::BehindBgPriority+i, x, y, outputBuffer, screenWidth);
 	}
 	
 	if(hdPackTileInfo) {
@@ -320,7 +356,7 @@ void HdNesPack::GetPixels(uint32_t x, uint32_t y, HdPpuPixelInfo &pixelInfo, uin
 	}
 
 	for(int i = 0; i < _activeBgCount[2]; i++) {
-		DrawBackgroundLayer(HdNesPack::BehindFgSpritesPriority+i, x, y, outputBuffer, screenWidth);
+		DrawBackgroundLayer(state, HdNesPack::BehindFgSpritesPriority+i, x, y, outputBuffer, screenWidth);
 	}
 
 	if(hasSprite) {
@@ -337,30 +373,83 @@ void HdNesPack::GetPixels(uint32_t x, uint32_t y, HdPpuPixelInfo &pixelInfo, uin
 	}
 
 	for(int i = 0; i < _activeBgCount[3]; i++) {
-		DrawBackgroundLayer(HdNesPack::ForegroundPriority+i, x, y, outputBuffer, screenWidth);
+		DrawBackgroundLayer(state, HdNesPack::ForegroundPriority+i, x, y, outputBuffer, screenWidth);
 	}
 }
 
-void HdNesPack::Process(HdScreenInfo *hdScreenInfo, uint32_t* outputBuffer, OverscanDimensions &overscan)
+void HdNesPack::ProcessLines(uint32_t startRow, uint32_t endRow, uint32_t* outputBuffer, OverscanDimensions &overscan)
 {
-	_hdScreenInfo = hdScreenInfo;
 	uint32_t hdScale = GetScale();
 	uint32_t screenWidth = overscan.GetScreenWidth() * hdScale;
 
-	OnBeforeApplyFilter();
-	for(uint32_t i = overscan.Top, iMax = 240 - overscan.Bottom; i < iMax; i++) {
-		OnLineStart(hdScreenInfo->ScreenTiles[i << 8], i);
+	HdLineState state;
+	memcpy(state.BgConfig, _bgConfig, sizeof(_bgConfig));
+
+	for(uint32_t i = startRow; i < endRow; i++) {
+		HdPpuPixelInfo *line = _hdScreenInfo->ScreenTiles + (i << 8);
+		OnLineStart(state, line[0], i);
 		uint32_t bufferIndex = (i - overscan.Top) * screenWidth * hdScale;
 		uint32_t lineStartIndex = bufferIndex;
-		for(uint32_t j = overscan.Left, jMax = 256 - overscan.Right; j < jMax; j++) {
-			GetPixels(j, i, hdScreenInfo->ScreenTiles[i * 256 + j], outputBuffer + bufferIndex, screenWidth);
-			bufferIndex += hdScale;
+		for(uint32_t j = overscan.Left, jMax = 256 - overscan.Right; j < jMax;) {
+			HdPpuPixelInfo &pixelInfo = line[j];
+			HdPackTileInfo *hdPackTileInfo = nullptr;
+			if(pixelInfo.Tile.TileIndex != HdPpuTileInfo::NoTile) {
+				hdPackTileInfo = GetCachedMatchingTile(state, j, i, &pixelInfo.Tile);
+			}
+
+			if(hdPackTileInfo && !hdPackTileInfo->HasTransparentPixels && !hdPackTileInfo->IsFullyTransparent && hdPackTileInfo->Brightness == 255 && !IsBgTileCovered(state, j, pixelInfo)) {
+				//Nothing shows through or over this opaque tile, draw it along with the next pixels that reuse the same cached tile
+				uint32_t pixelCount = 1;
+				while(j + pixelCount < jMax && state.UseCachedTile && ((state.ScrollX + j + pixelCount) & 0x07) != 0) {
+					HdPpuTileInfo &prevTile = line[j + pixelCount - 1].Tile;
+					HdPpuPixelInfo &next = line[j + pixelCount];
+					if(
+						next.Tile.TileIndex == HdPpuTileInfo::NoTile || next.Tile.OffsetX != prevTile.OffsetX + 1 || next.Tile.OffsetY != prevTile.OffsetY ||
+						next.Tile.HorizontalMirroring != prevTile.HorizontalMirroring || next.Tile.VerticalMirroring != prevTile.VerticalMirroring ||
+						IsBgTileCovered(state, j + pixelCount, next)
+					) {
+						break;
+					}
+					pixelCount++;
+				}
+
+				DrawTileSpan(pixelInfo.Tile, *hdPackTileInfo, pixelCount, outputBuffer + bufferIndex, screenWidth);
+				j += pixelCount;
+				bufferIndex += pixelCount * hdScale;
+			} else {
+				GetPixels(state, hdPackTileInfo, j, i, pixelInfo, outputBuffer + bufferIndex, screenWidth);
+				j++;
+				bufferIndex += hdScale;
+			}
 		}
 
-		ProcessGrayscaleAndEmphasis(hdScreenInfo->ScreenTiles[i * 256], outputBuffer + lineStartIndex, screenWidth);
+		ProcessGrayscaleAndEmphasis(line[0], outputBuffer + lineStartIndex, screenWidth);
 	}
 }
 
+void HdNesPack::Process(HdScreenInfo *hdScreenInfo, uint32_t* outputBuffer, OverscanDimensions &overscan)
+{
+	_hdScreenInfo = hdScreenInfo;
+
+	uint32_t threadCount = _settings->GetVideoFilterThreadCount();
+	if(threadCount == 0) {
+		threadCount = ThreadPool::GetDefaultThreadCount();
+	}
+	if(!_threadPool || _threadPool->GetThreadCount() != threadCount) {
+		_threadPool.reset(new ThreadPool(threadCount));
+	}
+
+	OnBeforeApplyFilter();
+
+	//Scanlines are independent once the frame's conditions are evaluated - split them in more bands than threads, since their cost varies a lot
+	uint32_t firstRow = overscan.Top;
+	uint32_t rowCount = 240 - overscan.Top - overscan.Bottom;
+	uint32_t bandCount = threadCount == 1 ? 1 : std::min<uint32_t>(threadCount * 4, rowCount);
+	_threadPool->Run(bandCount, [=, &overscan](uint32_t band) {
+		ProcessLines(firstRow + rowCount * band / bandCount, firstRow + rowCount * (band + 1) / bandCount, outputBuffer, overscan);
+	});
+}
+
 void HdNesPack::ProcessGrayscaleAndEmphasis(HdPpuPixelInfo &pixelInfo, uint32_t* outputBuffer, uint32_t hdScreenWidth)
 {
 	//Apply grayscale/emphasis bits on a scanline level (less accurate, but shouldn't cause issues and simpler to implement)
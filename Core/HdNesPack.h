@@ -1,6 +1,7 @@
 #pragma once
 #include "stdafx.h"
 #include "HdData.h"
+#include "../Utilities/ThreadPool.h"
 
 class EmulationSettings;
 
@@ -16,8 +17,18 @@ private:
 		int16_t BgMaxX = -1;
 	};
 
+	//Per-scanline rendering state, each band of scanlines (and thread) has its own copy
+	struct HdLineState
+	{
+		HdBgConfig BgConfig[40];
+		HdPackTileInfo* CachedTile = nullptr;
+		bool UseCachedTile = false;
+		int32_t ScrollX = 0;
+	};
+
 	shared_ptr<HdPackData> _hdData;
 	EmulationSettings *_settings;
+	std::unique_ptr<ThreadPool> _threadPool;
 
 	static constexpr uint8_t PriorityLevelsPerLayer = 10;
 	static constexpr uint8_t BehindBgSpritesPriority = 0 * PriorityLevelsPerLayer;
@@ -30,26 +41,26 @@ private:
 
 	HdScreenInfo *_hdScreenInfo = nullptr;
 	uint32_t* _palette = nullptr;
-	HdPackTileInfo* _cachedTile = nullptr;
 	bool _cacheEnabled = false;
-	bool _useCachedTile = false;
-	int32_t _scrollX = 0;
 
 	__forceinline void BlendColors(uint8_t output[4], uint8_t input[4]);
 	__forceinline uint32_t AdjustBrightness(uint8_t input[4], int brightness);
 	__forceinline void DrawColor(uint32_t color, uint32_t* outputBuffer, uint32_t scale, uint32_t screenWidth);
 	__forceinline void DrawTile(HdPpuTileInfo &tileInfo, HdPackTileInfo &hdPackTileInfo, uint32_t* outputBuffer, uint32_t screenWidth);
+	__forceinline void DrawTileSpan(HdPpuTileInfo &tileInfo, HdPackTileInfo &hdPackTileInfo, uint32_t pixelCount, uint32_t* outputBuffer, uint32_t screenWidth);
 	
-	__forceinline HdPackTileInfo* GetCachedMatchingTile(uint32_t x, uint32_t y, HdPpuTileInfo* tile);
+	__forceinline HdPackTileInfo* GetCachedMatchingTile(HdLineState &state, uint32_t x, uint32_t y, HdPpuTileInfo* tile);
 	__forceinline HdPackTileInfo* GetMatchingTile(uint32_t x, uint32_t y, HdPpuTileInfo* tile, bool* disableCache = nullptr);
 
-	__forceinline bool DrawBackgroundLayer(uint8_t priority, uint32_t x, uint32_t y, uint32_t* outputBuffer, uint32_t screenWidth);
+	__forceinline bool IsBgTileCovered(HdLineState &state, uint32_t x, HdPpuPixelInfo &pixelInfo);
+	__forceinline bool DrawBackgroundLayer(HdLineState &state, uint8_t priority, uint32_t x, uint32_t y, uint32_t* outputBuffer, uint32_t screenWidth);
 	__forceinline void DrawCustomBackground(HdBackgroundInfo& bgInfo, uint32_t *outputBuffer, uint32_t x, uint32_t y, uint32_t scale, uint32_t screenWidth);
 
-	void OnLineStart(HdPpuPixelInfo &lineFirstPixel, uint8_t y);
+	void OnLineStart(HdLineState &state, HdPpuPixelInfo &lineFirstPixel, uint8_t y);
 	int32_t GetLayerIndex(uint8_t priority);
 	void OnBeforeApplyFilter();
-	__forceinline void GetPixels(uint32_t x, uint32_t y, HdPpuPixelInfo &pixelInfo, uint32_t *outputBuffer, uint32_t screenWidth);
+	void ProcessLines(uint32_t startRow, uint32_t endRow, uint32_t* outputBuffer, OverscanDimensions &overscan);
+	__forceinline void GetPixels(HdLineState &state, HdPackTileInfo* hdPackTileInfo, uint32_t x, uint32_t y, HdPpuPixelInfo &pixelInfo, uint32_t *outputBuffer, uint32_t screenWidth);
 	__forceinline void ProcessGrayscaleAndEmphasis(HdPpuPixelInfo &pixelInfo, uint32_t* outputBuffer, uint32_t hdScreenWidth);
 
 public:
@@ -6,10 +6,12 @@
 #include "../Utilities/StringUtilities.h"
 #include "../Utilities/HexUtilities.h"
 #include "../Utilities/PNGHelper.h"
+#include "../Utilities/CRC32.h"
 #include "Console.h"
 #include "HdPackLoader.h"
 #include "HdPackConditions.h"
 #include "HdNesPack.h"
+#include "MessageManager.h"
 
 #define checkConstraint(x, y) if(!(x)) { return; }
 
@@ -22,6 +24,78 @@ static const char unixSlash    = '/';
 #endif
 #define convertPathToNativeVector(vector, idx) if (vector.size() > idx) { convertPathToNative(vector[idx]); }
 
+//Compiled pack (hires.bin) layout: header, definition text (every line of hires.txt except <img> and <tile> tags), background and source file names,
+//tile records, tile condition indexes, background records, source file records, then the premultiplied pixels of every tile and background
+static constexpr uint32_t CompiledPackMagic = 0x5044484D; //"MHDP"
+static constexpr uint32_t CompiledPackFormatVersion = 2;
+
+struct HdCompiledPackHeader
+{
+	uint32_t Magic;
+	uint32_t FormatVersion;
+	uint32_t PackVersion;
+	uint32_t DefinitionCrc;
+	uint32_t Scale;
+	uint32_t ConditionCount;
+	uint32_t TileCount;
+	uint32_t ConditionIndexCount;
+	uint32_t BackgroundCount;
+	uint32_t DefinitionSize;
+	uint32_t SourceFileCount;
+	uint32_t Reserved;
+	uint64_t DefinitionOffset;
+	uint64_t TileOffset;
+	uint64_t ConditionIndexOffset;
+	uint64_t BackgroundOffset;
+	uint64_t SourceFileOffset;
+};
+
+enum HdCompiledTileFlags
+{
+	IsChrRamTile = 0x01,
+	DefaultTile = 0x02,
+	Blank = 0x04,
+	HasTransparentPixels = 0x08,
+	TransparencyRequired = 0x10,
+	IsFullyTransparent = 0x20,
+	ForceDisableCache = 0x40
+};
+
+struct HdCompiledPackTile
+{
+	uint32_t PaletteColors;
+	uint8_t TileData[16];
+	int32_t TileIndex;
+	uint32_t X;
+	uint32_t Y;
+	uint32_t BitmapIndex;
+	int32_t Brightness;
+	uint32_t ChrBankId;
+	uint32_t FirstCondition;
+	uint32_t ConditionCount;
+	uint32_t Flags;
+	uint64_t PixelOffset;
+};
+
+struct HdCompiledPackBackground
+{
+	uint64_t NameOffset;
+	uint32_t NameLength;
+	uint32_t Width;
+	uint32_t Height;
+	uint32_t Reserved;
+	uint64_t PixelOffset;
+};
+
+//PNG file read when compiling the pack (<img> and <background> tags) - the compiled pack is outdated when any of them changed
+struct HdCompiledPackSourceFile
+{
+	uint64_t NameOffset;
+	uint32_t NameLength;
+	uint32_t Crc;
+	uint64_t Size;
+};
+
 HdPackLoader::HdPackLoader()
 {
 }
@@ -83,15 +157,43 @@ bool HdPackLoader::LoadHdNesPack(string definitionFile, HdPackData &outData)
 	return false;
 }
 
-bool HdPackLoader::LoadHdNesPack(VirtualFile &romFile, HdPackData &outData)
+bool HdPackLoader::LoadHdNesPack(VirtualFile &romFile, HdPackData &outData, size_t tileCacheSize, bool compilePack)
 {
 	HdPackLoader loader;
 	if(loader.InitializeLoader(romFile, &outData)) {
-		return loader.LoadPack();
+		loader._useCompiledPack = true;
+		//Compiling needs every tile's pixels, the tile cache is not used in that case
+		loader._compilePack = compilePack && !loader._loadFromZip;
+		loader._tileCacheSize = loader._compilePack ? 0 : tileCacheSize;
+		if(!loader.LoadPack()) {
+			return false;
+		}
+
+		if(loader._compilePack && !outData.CompiledPack) {
+			if(loader.SaveCompiledPack()) {
+				MessageManager::Log("[HDPack] Compiled pack saved to hires.bin");
+			} else {
+				MessageManager::Log("[HDPack] Could not write hires.bin");
+			}
+		}
+		return true;
 	}
 	return false;
 }
 
+bool HdPackLoader::CompileHdPack(VirtualFile &romFile)
+{
+	HdPackData data;
+	HdPackLoader loader;
+	if(!loader.InitializeLoader(romFile, &data) || loader._loadFromZip) {
+		//Only packs stored in a folder can be compiled
+		return false;
+	}
+
+	loader._compilePack = true;
+	return loader.LoadPack() && loader.SaveCompiledPack();
+}
+
 bool HdPackLoader::CheckFile(string filename)
 {
 	if(_loadFromZip) {
@@ -106,6 +208,13 @@ bool HdPackLoader::CheckFile(string filename)
 	return false;
 }
 
+void HdPackLoader::AddSourceFile(string filename, vector<uint8_t> &fileData)
+{
+	if(_compilePack) {
+		_sourceFiles.push_back({ filename, fileData.size(), CRC32::GetCRC(fileData.data(), fileData.size()) });
+	}
+}
+
 bool HdPackLoader::LoadFile(string filename, vector<uint8_t> &fileData)
 {
 	fileData.clear();
@@ -133,76 +242,32 @@ bool HdPackLoader::LoadFile(string filename, vector<uint8_t> &fileData)
 
 bool HdPackLoader::LoadPack()
 {
-	string currentLine;
 	try {
 		vector<uint8_t> hdDefinition;
 		if(!LoadFile("hires.txt", hdDefinition)) {
 			return false;
 		}
 
-		InitializeGlobalConditions();
+		_definitionCrc = CRC32::GetCRC(hdDefinition.data(), hdDefinition.size());
+		if(_useCompiledPack && !_loadFromZip && LoadCompiledPack()) {
+			return true;
+		}
 
-		for(string lineContent : StringUtilities::Split(string(hdDefinition.data(), hdDefinition.data() + hdDefinition.size()), '\n')) {
-			if(lineContent.empty()) {
-				continue;
-			}
+		if(_tileCacheSize > 0) {
+			//Compiled packs are already loaded on demand (by the OS), only text packs use the cache
+			_data->BitmapCache.reset(new HdTileBitmapCache(_hdPackFolder, _loadFromZip, _tileCacheSize));
+		}
 
-			if(lineContent[lineContent.size() - 1] == '\r') {
-				lineContent = lineContent.substr(0, lineContent.size() - 1);
-			}
-			currentLine = lineContent;			
+		InitializeGlobalConditions();
 
-			vector<HdPackCondition*> conditions;
-			if(lineContent.substr(0, 1) == "[") {
-				size_t endOfCondition = lineContent.find_first_of(']', 1);
-				conditions = ParseConditionString(lineContent.substr(1, endOfCondition - 1), _data->Conditions);
-				lineContent = lineContent.substr(endOfCondition + 1);
+		for(string lineContent : StringUtilities::Split(string(hdDefinition.data(), hdDefinition.data() + hdDefinition.size()), '\n')) {
+			if(!ProcessDefinitionLine(lineContent)) {
+				return false;
 			}
+		}
 
-			vector<string> tokens;
-			if(lineContent.substr(0, 5) == "<ver>") {
-				_data->Version = stoi(lineContent.substr(5));
-				if(_data->Version > HdNesPack::CurrentVersion)
-					return false;
-			} else if(lineContent.substr(0, 7) == "<scale>") {
-				lineContent = lineContent.substr(7);
-				_data->Scale = std::stoi(lineContent);
-			} else if(lineContent.substr(0, 10) == "<overscan>") {
-				tokens = StringUtilities::Split(lineContent.substr(10), ',');
-				ProcessOverscanTag(tokens);
-			} else if(lineContent.substr(0, 5) == "<img>") {
-				lineContent = lineContent.substr(5);
-				convertPathToNative(lineContent);
-				if(!ProcessImgTag(lineContent)) {
-					return false;
-				}
-			} else if(lineContent.substr(0, 7) == "<patch>") {
-				tokens = StringUtilities::Split(lineContent.substr(7), ',');
-				convertPathToNativeVector(tokens, 0);
-				ProcessPatchTag(tokens);
-			} else if(lineContent.substr(0, 12) == "<background>") {
-				tokens = StringUtilities::Split(lineContent.substr(12), ',');
-				convertPathToNativeVector(tokens, 0);
-				ProcessBackgroundTag(tokens, conditions);
-			} else if(lineContent.substr(0, 11) == "<condition>") {
-				tokens = StringUtilities::Split(lineContent.substr(11), ',');
-				ProcessConditionTag(tokens, false);
-				ProcessConditionTag(tokens, true);
-			} else if(lineContent.substr(0, 6) == "<tile>") {
-				tokens = StringUtilities::Split(lineContent.substr(6), ',');
-				ProcessTileTag(tokens, conditions);
-			} else if(lineContent.substr(0, 9) == "<options>") {
-				tokens = StringUtilities::Split(lineContent.substr(9), ',');
-				ProcessOptionTag(tokens);
-			} else if(lineContent.substr(0, 5) == "<bgm>") {
-				tokens = StringUtilities::Split(lineContent.substr(5), ',');
-				convertPathToNativeVector(tokens, 2);
-				ProcessBgmTag(tokens);
-			} else if(lineContent.substr(0, 5) == "<sfx>") {
-				tokens = StringUtilities::Split(lineContent.substr(5), ',');
-				convertPathToNativeVector(tokens, 2);
-				ProcessSfxTag(tokens);
-			}
+		if(_data->BitmapCache) {
+			_data->BitmapCache->Initialize(_data->Tiles, _data->Scale);
 		}
 
 		LoadCustomPalette();
@@ -214,12 +279,395 @@ bool HdPackLoader::LoadPack()
 	}
 }
 
+bool HdPackLoader::ProcessDefinitionLine(string lineContent)
+{
+	if(lineContent.empty()) {
+		return true;
+	}
+
+	if(lineContent[lineContent.size() - 1] == '\r') {
+		lineContent = lineContent.substr(0, lineContent.size() - 1);
+	}
+	string line = lineContent;
+
+	vector<HdPackCondition*> conditions;
+	if(lineContent.substr(0, 1) == "[") {
+		size_t endOfCondition = lineContent.find_first_of(']', 1);
+		conditions = ParseConditionString(lineContent.substr(1, endOfCondition - 1), _data->Conditions);
+		lineContent = lineContent.substr(endOfCondition + 1);
+	}
+
+	if(_compilePack && lineContent.substr(0, 5) != "<img>" && lineContent.substr(0, 6) != "<tile>") {
+		//Everything but the tiles and their bitmaps is cheap to parse, the compiled pack keeps these lines as text
+		_definitionLines.push_back(line);
+	}
+
+	vector<string> tokens;
+	if(lineContent.substr(0, 5) == "<ver>") {
+		_data->Version = stoi(lineContent.substr(5));
+		if(_data->Version > HdNesPack::CurrentVersion)
+			return false;
+	} else if(lineContent.substr(0, 7) == "<scale>") {
+		lineContent = lineContent.substr(7);
+		_data->Scale = std::stoi(lineContent);
+	} else if(lineContent.substr(0, 10) == "<overscan>") {
+		tokens = StringUtilities::Split(lineContent.substr(10), ',');
+		ProcessOverscanTag(tokens);
+	} else if(lineContent.substr(0, 5) == "<img>") {
+		lineContent = lineContent.substr(5);
+		convertPathToNative(lineContent);
+		if(!ProcessImgTag(lineContent)) {
+			return false;
+		}
+	} else if(lineContent.substr(0, 7) == "<patch>") {
+		tokens = StringUtilities::Split(lineContent.substr(7), ',');
+		convertPathToNativeVector(tokens, 0);
+		ProcessPatchTag(tokens);
+	} else if(lineContent.substr(0, 12) == "<background>") {
+		tokens = StringUtilities::Split(lineContent.substr(12), ',');
+		convertPathToNativeVector(tokens, 0);
+		ProcessBackgroundTag(tokens, conditions);
+	} else if(lineContent.substr(0, 11) == "<condition>") {
+		tokens = StringUtilities::Split(lineContent.substr(11), ',');
+		ProcessConditionTag(tokens, false);
+		ProcessConditionTag(tokens, true);
+	} else if(lineContent.substr(0, 6) == "<tile>") {
+		tokens = StringUtilities::Split(lineContent.substr(6), ',');
+		ProcessTileTag(tokens, conditions);
+	} else if(lineContent.substr(0, 9) == "<options>") {
+		tokens = StringUtilities::Split(lineContent.substr(9), ',');
+		ProcessOptionTag(tokens);
+	} else if(lineContent.substr(0, 5) == "<bgm>") {
+		tokens = StringUtilities::Split(lineContent.substr(5), ',');
+		convertPathToNativeVector(tokens, 2);
+		ProcessBgmTag(tokens);
+	} else if(lineContent.substr(0, 5) == "<sfx>") {
+		tokens = StringUtilities::Split(lineContent.substr(5), ',');
+		convertPathToNativeVector(tokens, 2);
+		ProcessSfxTag(tokens);
+	}
+	return true;
+}
+
+bool HdPackLoader::LoadCompiledPack()
+{
+	unique_ptr<MemoryMappedFile> file(new MemoryMappedFile());
+	if(!file->Open(FolderUtilities::CombinePath(_hdPackFolder, "hires.bin"))) {
+		return false;
+	}
+
+	uint8_t* data = file->GetData();
+	uint64_t size = file->GetSize();
+	auto isInFile = [size](uint64_t offset, uint64_t length) { return offset <= size && length <= size - offset; };
+
+	HdCompiledPackHeader header;
+	if(size < sizeof(header)) {
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+
+	if(header.Magic != CompiledPackMagic || header.FormatVersion != CompiledPackFormatVersion || header.PackVersion != HdNesPack::CurrentVersion || header.DefinitionCrc != _definitionCrc) {
+		//Outdated, hires.txt was modified since the pack was compiled
+		return false;
+	}
+
+	if(
+		header.TileOffset % 8 || header.BackgroundOffset % 8 || header.ConditionIndexOffset % 4 ||
+		!isInFile(header.DefinitionOffset, header.DefinitionSize) ||
+		!isInFile(header.TileOffset, (uint64_t)header.TileCount * sizeof(HdCompiledPackTile)) ||
+		!isInFile(header.ConditionIndexOffset, (uint64_t)header.ConditionIndexCount * sizeof(uint32_t)) ||
+		!isInFile(header.BackgroundOffset, (uint64_t)header.BackgroundCount * sizeof(HdCompiledPackBackground)) ||
+		header.SourceFileOffset % 8 || !isInFile(header.SourceFileOffset, (uint64_t)header.SourceFileCount * sizeof(HdCompiledPackSourceFile))
+	) {
+		return false;
+	}
+
+	//The tile and background pixels come from the PNG files, which can be edited without changing hires.txt
+	HdCompiledPackSourceFile* sourceFiles = (HdCompiledPackSourceFile*)(data + header.SourceFileOffset);
+	for(uint32_t i = 0; i < header.SourceFileCount; i++) {
+		HdCompiledPackSourceFile &sourceFile = sourceFiles[i];
+		if(!isInFile(sourceFile.NameOffset, sourceFile.NameLength)) {
+			return false;
+		}
+
+		string name((char*)data + sourceFile.NameOffset, sourceFile.NameLength);
+		vector<uint8_t> fileData;
+		if(!LoadFile(name, fileData) || fileData.size() != sourceFile.Size || CRC32::GetCRC(fileData.data(), fileData.size()) != sourceFile.Crc) {
+			MessageManager::Log("[HDPack] hires.bin is outdated (" + name + " was modified), loading hires.txt instead");
+			return false;
+		}
+	}
+
+	HdCompiledPackTile* tiles = (HdCompiledPackTile*)(data + header.TileOffset);
+	uint32_t* conditionIndexes = (uint32_t*)(data + header.ConditionIndexOffset);
+	HdCompiledPackBackground* backgrounds = (HdCompiledPackBackground*)(data + header.BackgroundOffset);
+
+	//Validate everything before filling the pack data
+	uint64_t tileSize = 64 * header.Scale * header.Scale * sizeof(uint32_t);
+	for(uint32_t i = 0; i < header.TileCount; i++) {
+		HdCompiledPackTile &tile = tiles[i];
+		if(tile.PixelOffset % 4 || !isInFile(tile.PixelOffset, tileSize) || (uint64_t)tile.FirstCondition + tile.ConditionCount > header.ConditionIndexCount) {
+			return false;
+		}
+	}
+	for(uint32_t i = 0; i < header.ConditionIndexCount; i++) {
+		if(conditionIndexes[i] >= header.ConditionCount) {
+			return false;
+		}
+	}
+	for(uint32_t i = 0; i < header.BackgroundCount; i++) {
+		HdCompiledPackBackground &bg = backgrounds[i];
+		if(bg.PixelOffset % 4 || !isInFile(bg.NameOffset, bg.NameLength) || !isInFile(bg.PixelOffset, (uint64_t)bg.Width * bg.Height * sizeof(uint32_t))) {
+			return false;
+		}
+	}
+
+	//Backgrounds are added first, so <background> tags use their decoded pixels instead of loading the PNG files
+	for(uint32_t i = 0; i < header.BackgroundCount; i++) {
+		HdCompiledPackBackground &bg = backgrounds[i];
+		HdBackgroundFileData* bgFileData = new HdBackgroundFileData();
+		bgFileData->PngName = string((char*)data + bg.NameOffset, bg.NameLength);
+		bgFileData->Width = bg.Width;
+		bgFileData->Height = bg.Height;
+		bgFileData->MappedPixelData = (uint32_t*)(data + bg.PixelOffset);
+		_data->BackgroundFileData.push_back(unique_ptr<HdBackgroundFileData>(bgFileData));
+	}
+
+	InitializeGlobalConditions();
+
+	bool definitionValid = true;
+	string definition((char*)data + header.DefinitionOffset, header.DefinitionSize);
+	for(string lineContent : StringUtilities::Split(definition, '\n')) {
+		if(!ProcessDefinitionLine(lineContent)) {
+			definitionValid = false;
+			break;
+		}
+	}
+
+	if(!definitionValid || _data->Conditions.size() != header.ConditionCount || _data->Scale != header.Scale) {
+		//Inconsistent file, undo everything so the pack can be loaded from hires.txt instead
+		_data->Backgrounds.clear();
+		_data->BackgroundFileData.clear();
+		_data->Conditions.clear();
+		_data->WatchedMemoryAddresses.clear();
+		_data->PatchesByHash.clear();
+		_data->BgmFilesById.clear();
+		_data->SfxFilesById.clear();
+		_data->HasOverscanConfig = false;
+		_data->Overscan = {};
+		_data->Scale = 1;
+		_data->Version = 0;
+		_data->OptionFlags = 0;
+		return false;
+	}
+
+	_data->Tiles.reserve(header.TileCount);
+	for(uint32_t i = 0; i < header.TileCount; i++) {
+		HdCompiledPackTile &tile = tiles[i];
+		HdPackTileInfo* tileInfo = new HdPackTileInfo();
+		tileInfo->PaletteColors = tile.PaletteColors;
+		memcpy(tileInfo->TileData, tile.TileData, sizeof(tile.TileData));
+		tileInfo->TileIndex = tile.TileIndex;
+		tileInfo->X = tile.X;
+		tileInfo->Y = tile.Y;
+		tileInfo->BitmapIndex = tile.BitmapIndex;
+		tileInfo->Brightness = tile.Brightness;
+		tileInfo->ChrBankId = tile.ChrBankId;
+		tileInfo->IsChrRamTile = (tile.Flags & HdCompiledTileFlags::IsChrRamTile) != 0;
+		tileInfo->DefaultTile = (tile.Flags & HdCompiledTileFlags::DefaultTile) != 0;
+		tileInfo->Blank = (tile.Flags & HdCompiledTileFlags::Blank) != 0;
+		tileInfo->HasTransparentPixels = (tile.Flags & HdCompiledTileFlags::HasTransparentPixels) != 0;
+		tileInfo->TransparencyRequired = (tile.Flags & HdCompiledTileFlags::TransparencyRequired) != 0;
+		tileInfo->IsFullyTransparent = (tile.Flags & HdCompiledTileFlags::IsFullyTransparent) != 0;
+		tileInfo->ForceDisableCache = (tile.Flags & HdCompiledTileFlags::ForceDisableCache) != 0;
+		for(uint32_t j = 0; j < tile.ConditionCount; j++) {
+			tileInfo->Conditions.push_back(_data->Conditions[conditionIndexes[tile.FirstCondition + j]].get());
+		}
+		tileInfo->MappedTileData = (uint32_t*)(data + tile.PixelOffset);
+		_data->Tiles.push_back(unique_ptr<HdPackTileInfo>(tileInfo));
+	}
+
+	LoadCustomPalette();
+	InitializeHdPack();
+
+	_data->CompiledPack = std::move(file);
+	return true;
+}
+
+bool HdPackLoader::SaveCompiledPack()
+{
+	auto align = [](uint64_t offset, uint64_t alignment) { return (offset + alignment - 1) / alignment * alignment; };
+
+	string definition;
+	for(string &line : _definitionLines) {
+		definition += line + "\n";
+	}
+
+	string names;
+	for(unique_ptr<HdBackgroundFileData> &bgData : _data->BackgroundFileData) {
+		names += bgData->PngName;
+	}
+	for(SourceFileInfo &sourceFile : _sourceFiles) {
+		names += sourceFile.Name;
+	}
+
+	std::unordered_map<HdPackCondition*, uint32_t> conditionIndexById;
+	for(size_t i = 0; i < _data->Conditions.size(); i++) {
+		conditionIndexById[_data->Conditions[i].get()] = (uint32_t)i;
+	}
+
+	HdCompiledPackHeader header = {};
+	header.Magic = CompiledPackMagic;
+	header.FormatVersion = CompiledPackFormatVersion;
+	header.PackVersion = HdNesPack::CurrentVersion;
+	header.DefinitionCrc = _definitionCrc;
+	header.Scale = _data->Scale;
+	header.ConditionCount = (uint32_t)_data->Conditions.size();
+	header.TileCount = (uint32_t)_data->Tiles.size();
+	header.BackgroundCount = (uint32_t)_data->BackgroundFileData.size();
+	header.SourceFileCount = (uint32_t)_sourceFiles.size();
+	header.DefinitionSize = (uint32_t)definition.size();
+	header.DefinitionOffset = sizeof(header);
+
+	uint64_t namesOffset = header.DefinitionOffset + definition.size();
+	header.TileOffset = align(namesOffset + names.size(), 8);
+
+	//Tile records, with the position of their pixels (every tile has the same size, stored after the records)
+	vector<HdCompiledPackTile> tiles;
+	vector<uint32_t> conditionIndexes;
+	uint64_t tileSize = 64 * _data->Scale * _data->Scale * sizeof(uint32_t);
+	for(unique_ptr<HdPackTileInfo> &tileInfo : _data->Tiles) {
+		if(tileInfo->HdTileData.size() * sizeof(uint32_t) != tileSize) {
+			return false;
+		}
+
+		HdCompiledPackTile tile = {};
+		tile.PaletteColors = tileInfo->PaletteColors;
+		memcpy(tile.TileData, tileInfo->TileData, sizeof(tile.TileData));
+		tile.TileIndex = tileInfo->TileIndex;
+		tile.X = tileInfo->X;
+		tile.Y = tileInfo->Y;
+		tile.BitmapIndex = tileInfo->BitmapIndex;
+		tile.Brightness = tileInfo->Brightness;
+		tile.ChrBankId = tileInfo->ChrBankId;
+		tile.Flags = (
+			(tileInfo->IsChrRamTile ? HdCompiledTileFlags::IsChrRamTile : 0) |
+			(tileInfo->DefaultTile ? HdCompiledTileFlags::DefaultTile : 0) |
+			(tileInfo->Blank ? HdCompiledTileFlags::Blank : 0) |
+			(tileInfo->HasTransparentPixels ? HdCompiledTileFlags::HasTransparentPixels : 0) |
+			(tileInfo->TransparencyRequired ? HdCompiledTileFlags::TransparencyRequired : 0) |
+			(tileInfo->IsFullyTransparent ? HdCompiledTileFlags::IsFullyTransparent : 0) |
+			(tileInfo->ForceDisableCache ? HdCompiledTileFlags::ForceDisableCache : 0)
+		);
+		tile.FirstCondition = (uint32_t)conditionIndexes.size();
+		tile.ConditionCount = (uint32_t)tileInfo->Conditions.size();
+		for(HdPackCondition* condition : tileInfo->Conditions) {
+			conditionIndexes.push_back(conditionIndexById[condition]);
+		}
+		tiles.push_back(tile);
+	}
+	header.ConditionIndexCount = (uint32_t)conditionIndexes.size();
+	header.ConditionIndexOffset = header.TileOffset + tiles.size() * sizeof(HdCompiledPackTile);
+	header.BackgroundOffset = align(header.ConditionIndexOffset + conditionIndexes.size() * sizeof(uint32_t), 8);
+
+	header.SourceFileOffset = header.BackgroundOffset + _data->BackgroundFileData.size() * sizeof(HdCompiledPackBackground);
+
+	uint64_t pixelOffset = align(header.SourceFileOffset + _sourceFiles.size() * sizeof(HdCompiledPackSourceFile), 64);
+	for(HdCompiledPackTile &tile : tiles) {
+		tile.PixelOffset = pixelOffset;
+		pixelOffset += tileSize;
+	}
+
+	vector<HdCompiledPackBackground> backgrounds;
+	uint64_t nameOffset = namesOffset;
+	for(unique_ptr<HdBackgroundFileData> &bgData : _data->BackgroundFileData) {
+		HdCompiledPackBackground bg = {};
+		bg.NameOffset = nameOffset;
+		bg.NameLength = (uint32_t)bgData->PngName.size();
+		bg.Width = bgData->Width;
+		bg.Height = bgData->Height;
+		bg.PixelOffset = pixelOffset;
+		nameOffset += bg.NameLength;
+		pixelOffset += bgData->PixelData.size() * sizeof(uint32_t);
+		backgrounds.push_back(bg);
+	}
+
+	vector<HdCompiledPackSourceFile> sourceFiles;
+	for(SourceFileInfo &sourceFileInfo : _sourceFiles) {
+		HdCompiledPackSourceFile sourceFile = {};
+		sourceFile.NameOffset = nameOffset;
+		sourceFile.NameLength = (uint32_t)sourceFileInfo.Name.size();
+		sourceFile.Crc = sourceFileInfo.Crc;
+		sourceFile.Size = sourceFileInfo.Size;
+		nameOffset += sourceFile.NameLength;
+		sourceFiles.push_back(sourceFile);
+	}
+
+	//Write to a temporary file first, processes that have the current file mapped keep using it
+	string filename = FolderUtilities::CombinePath(_hdPackFolder, "hires.bin");
+	string tmpFilename = filename + ".tmp";
+	{
+		ofstream file(tmpFilename, ios::out | ios::binary);
+		if(!file) {
+			return false;
+		}
+
+		auto writePadding = [&file](uint64_t offset) {
+			while((uint64_t)file.tellp() < offset) {
+				file.put(0);
+			}
+		};
+
+		file.write((char*)&header, sizeof(header));
+		file.write(definition.data(), definition.size());
+		file.write(names.data(), names.size());
+		writePadding(header.TileOffset);
+		file.write((char*)tiles.data(), tiles.size() * sizeof(HdCompiledPackTile));
+		file.write((char*)conditionIndexes.data(), conditionIndexes.size() * sizeof(uint32_t));
+		writePadding(header.BackgroundOffset);
+		file.write((char*)backgrounds.data(), backgrounds.size() * sizeof(HdCompiledPackBackground));
+		file.write((char*)sourceFiles.data(), sourceFiles.size() * sizeof(HdCompiledPackSourceFile));
+		writePadding(tiles.empty() ? (backgrounds.empty() ? 0 : backgrounds[0].PixelOffset) : tiles[0].PixelOffset);
+		for(unique_ptr<HdPackTileInfo> &tileInfo : _data->Tiles) {
+			file.write((char*)tileInfo->HdTileData.data(), tileSize);
+		}
+		for(unique_ptr<HdBackgroundFileData> &bgData : _data->BackgroundFileData) {
+			file.write((char*)bgData->PixelData.data(), bgData->PixelData.size() * sizeof(uint32_t));
+		}
+
+		if(!file) {
+			file.close();
+			std::remove(tmpFilename.c_str());
+			return false;
+		}
+	}
+
+	if(std::rename(tmpFilename.c_str(), filename.c_str()) != 0) {
+		//Windows can't rename over an existing file
+		std::remove(filename.c_str());
+		if(std::rename(tmpFilename.c_str(), filename.c_str()) != 0) {
+			std::remove(tmpFilename.c_str());
+			return false;
+		}
+	}
+	return true;
+}
+
 bool HdPackLoader::ProcessImgTag(string src)
 {
+	if(_data->BitmapCache) {
+		if(!CheckFile(src)) {
+			return false;
+		}
+		_data->BitmapCache->AddBitmap(src);
+		return true;
+	}
+
 	HdPackBitmapInfo bitmapInfo;
 	vector<uint8_t> fileData;
 	vector<uint8_t> pixelData;
 	LoadFile(src, fileData);
+	AddSourceFile(src, fileData);
 	if(PNGHelper::ReadPNG(fileData, pixelData, bitmapInfo.Width, bitmapInfo.Height)) {
 		bitmapInfo.PixelData.resize(pixelData.size() / 4);
 		memcpy(bitmapInfo.PixelData.data(), pixelData.data(), bitmapInfo.PixelData.size() * sizeof(bitmapInfo.PixelData[0]));
@@ -375,19 +823,27 @@ void HdPackLoader::ProcessTileTag(vector<string> &tokens, vector<HdPackCondition
 		}
 	}
 
-	checkConstraint(tileInfo->BitmapIndex < _hdNesBitmaps.size(), "[HDPack] Invalid bitmap index: " + std::to_string(tileInfo->BitmapIndex));
+	if(_data->BitmapCache) {
+		//Only the tile's flags are needed for now, its pixels are decoded again when it is drawn
+		checkConstraint(tileInfo->BitmapIndex < _data->BitmapCache->GetBitmapCount(), "[HDPack] Invalid bitmap index: " + std::to_string(tileInfo->BitmapIndex));
+		checkConstraint(_data->BitmapCache->DecodeTile(tileInfo, _data->Scale, tileInfo->HdTileData), "[HDPack] Invalid tile position");
+		tileInfo->UpdateFlags();
+		vector<uint32_t>().swap(tileInfo->HdTileData);
+	} else {
+		checkConstraint(tileInfo->BitmapIndex < _hdNesBitmaps.size(), "[HDPack] Invalid bitmap index: " + std::to_string(tileInfo->BitmapIndex));
 
-	HdPackBitmapInfo &bitmapInfo = _hdNesBitmaps[tileInfo->BitmapIndex];
-	uint32_t bitmapOffset = tileInfo->Y * bitmapInfo.Width + tileInfo->X;
-	uint32_t* pngData = (uint32_t*)bitmapInfo.PixelData.data();
-	
-	tileInfo->HdTileData.resize(64 * _data->Scale * _data->Scale);
-	for(uint32_t y = 0; y < 8 * _data->Scale; y++) {
-		memcpy(tileInfo->HdTileData.data() + (y * 8 * _data->Scale), pngData + bitmapOffset, 8 * _data->Scale * sizeof(uint32_t));
-		bitmapOffset += bitmapInfo.Width;
-	}
+		HdPackBitmapInfo &bitmapInfo = _hdNesBitmaps[tileInfo->BitmapIndex];
+		uint32_t bitmapOffset = tileInfo->Y * bitmapInfo.Width + tileInfo->X;
+		uint32_t* pngData = (uint32_t*)bitmapInfo.PixelData.data();
 
-	tileInfo->UpdateFlags();
+		tileInfo->HdTileData.resize(64 * _data->Scale * _data->Scale);
+		for(uint32_t y = 0; y < 8 * _data->Scale; y++) {
+			memcpy(tileInfo->HdTileData.data() + (y * 8 * _data->Scale), pngData + bitmapOffset, 8 * _data->Scale * sizeof(uint32_t));
+			bitmapOffset += bitmapInfo.Width;
+		}
+
+		tileInfo->UpdateFlags();
+	}
 
 	_data->Tiles.push_back(unique_ptr<HdPackTileInfo>(tileInfo));
 }
@@ -554,6 +1010,7 @@ void HdPackLoader::ProcessBackgroundTag(vector<string> &tokens, vector<HdPackCon
 		uint32_t width, height;
 		vector<uint8_t> fileContent;
 		if(LoadFile(tokens[0], fileContent)) {
+			AddSourceFile(tokens[0], fileContent);
 			if(PNGHelper::ReadPNG(fileContent, pixelData, width, height)) {
 				_data->BackgroundFileData.push_back(unique_ptr<HdBackgroundFileData>(new HdBackgroundFileData()));
 				bgFileData = _data->BackgroundFileData.back().get();
@@ -702,18 +1159,10 @@ void HdPackLoader::LoadCustomPalette()
 void HdPackLoader::InitializeHdPack()
 {
 	for(unique_ptr<HdPackTileInfo> &tileInfo : _data->Tiles) {
-		auto tiles = _data->TileByKey.find(tileInfo->GetKey(false));
-		if(tiles == _data->TileByKey.end()) {
-			_data->TileByKey[tileInfo->GetKey(false)] = vector<HdPackTileInfo*>();
-		}
-		_data->TileByKey[tileInfo->GetKey(false)].push_back(tileInfo.get());
+		_data->TileByKey.Add(tileInfo->GetKey(false), tileInfo.get());
 
 		if(tileInfo->DefaultTile) {
-			auto tiles = _data->TileByKey.find(tileInfo->GetKey(true));
-			if(tiles == _data->TileByKey.end()) {
-				_data->TileByKey[tileInfo->GetKey(true)] = vector<HdPackTileInfo*>();
-			}
-			_data->TileByKey[tileInfo->GetKey(true)].push_back(tileInfo.get());
+			_data->TileByKey.Add(tileInfo->GetKey(true), tileInfo.get());
 		}
 	}
 }
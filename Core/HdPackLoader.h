@@ -8,7 +8,14 @@ class HdPackLoader
 {
 public:
 	static bool LoadHdNesPack(string definitionFile, HdPackData &outData);
-	static bool LoadHdNesPack(VirtualFile &romFile, HdPackData &outData);
+	//When tileCacheSize isn't 0, the tiles' bitmaps are decoded when first drawn and at most tileCacheSize bytes of them are kept in memory
+	//When compilePack is set and the pack has no up to date hires.bin, it is compiled after loading hires.txt (see CompileHdPack)
+	static bool LoadHdNesPack(VirtualFile &romFile, HdPackData &outData, size_t tileCacheSize = 0, bool compilePack = false);
+
+	//Writes hires.bin next to the ROM's hires.txt - it is loaded instead of the text pack until hires.txt or one of its PNG files changes
+	static bool CompileHdPack(VirtualFile &romFile);
+
+	static void PremultiplyAlpha(vector<uint32_t>& pixelData);
 
 private:
 	HdPackData* _data;
@@ -18,13 +25,31 @@ private:
 	string _hdPackFolder;
 	vector<HdPackBitmapInfo> _hdNesBitmaps;
 
+	struct SourceFileInfo
+	{
+		string Name;
+		uint64_t Size;
+		uint32_t Crc;
+	};
+
+	bool _useCompiledPack = false;
+	bool _compilePack = false;
+	uint32_t _definitionCrc = 0;
+	size_t _tileCacheSize = 0;
+	vector<string> _definitionLines;
+	vector<SourceFileInfo> _sourceFiles;
+
 	HdPackLoader();
 
 	bool InitializeLoader(VirtualFile &romPath, HdPackData *data);
 	bool LoadFile(string filename, vector<uint8_t> &fileData);
 	bool CheckFile(string filename);
+	void AddSourceFile(string filename, vector<uint8_t> &fileData);
 
 	bool LoadPack();
+	bool ProcessDefinitionLine(string lineContent);
+	bool LoadCompiledPack();
+	bool SaveCompiledPack();
 	void InitializeHdPack();
 	void LoadCustomPalette();
 
@@ -32,7 +57,6 @@ private:
 
 	//Video
 	bool ProcessImgTag(string src);
-	void PremultiplyAlpha(vector<uint32_t>& pixelData);
 	void ProcessPatchTag(vector<string> &tokens);
 	void ProcessOverscanTag(vector<string> &tokens);
 	void ProcessConditionTag(vector<string> &tokens, bool createInvertedCondition);
@@ -157,4 +157,7 @@ void HdPpu::SendFrame()
 	}
 
 	_console->GetVideoDecoder()->UpdateFrameSync(_currentOutputBuffer, _info);
+
+	//Switch to the alternate buffer (VideoDecoder may still be decoding the last frame)
+	_info = (_info == _screenInfo[0]) ? _screenInfo[1] : _screenInfo[0];
 }
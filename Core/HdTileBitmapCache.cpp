@@ -0,0 +1,176 @@
+#include "stdafx.h"
+#include <algorithm>
+#include "../Utilities/FolderUtilities.h"
+#include "../Utilities/PNGHelper.h"
+#include "HdTileBitmapCache.h"
+#include "HdData.h"
+#include "HdPackLoader.h"
+
+HdTileBitmapCache::HdTileBitmapCache(string packPath, bool loadFromZip, size_t maxSize)
+{
+	_packPath = packPath;
+	_loadFromZip = loadFromZip;
+	_maxSize = maxSize;
+
+	if(_loadFromZip) {
+		_reader.LoadArchive(_packPath);
+	}
+}
+
+HdTileBitmapCache::~HdTileBitmapCache()
+{
+	for(uint32_t index : _decodedTiles) {
+		delete[] _tiles[index].Data.load();
+	}
+}
+
+bool HdTileBitmapCache::LoadFile(string filename, vector<uint8_t> &fileData)
+{
+	fileData.clear();
+
+	if(_loadFromZip) {
+		return _reader.ExtractFile(filename, fileData);
+	} else {
+		ifstream file(FolderUtilities::CombinePath(_packPath, filename), ios::in | ios::binary);
+		if(file.good()) {
+			file.seekg(0, ios::end);
+			uint32_t fileSize = (uint32_t)file.tellg();
+			file.seekg(0, ios::beg);
+
+			fileData = vector<uint8_t>(fileSize, 0);
+			file.read((char*)fileData.data(), fileSize);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool HdTileBitmapCache::LoadBitmap(uint32_t bitmapIndex)
+{
+	if(_bitmapIndex == (int32_t)bitmapIndex) {
+		return true;
+	}
+
+	_bitmapIndex = -1;
+	vector<uint8_t> fileData;
+	vector<uint8_t> pixelData;
+	if(bitmapIndex >= _bitmapFiles.size() || !LoadFile(_bitmapFiles[bitmapIndex], fileData) || !PNGHelper::ReadPNG(fileData, pixelData, _bitmapWidth, _bitmapHeight)) {
+		return false;
+	}
+
+	_bitmapPixels.resize(pixelData.size() / 4);
+	memcpy(_bitmapPixels.data(), pixelData.data(), _bitmapPixels.size() * sizeof(_bitmapPixels[0]));
+	HdPackLoader::PremultiplyAlpha(_bitmapPixels);
+	_bitmapIndex = bitmapIndex;
+	return true;
+}
+
+bool HdTileBitmapCache::CopyTile(HdPackTileInfo* tile, uint32_t scale, uint32_t* output)
+{
+	uint32_t tileWidth = 8 * scale;
+	if((uint64_t)tile->X + tileWidth > _bitmapWidth || (uint64_t)tile->Y + tileWidth > _bitmapHeight) {
+		return false;
+	}
+
+	uint32_t* bitmapData = _bitmapPixels.data() + tile->Y * _bitmapWidth + tile->X;
+	for(uint32_t y = 0; y < tileWidth; y++) {
+		memcpy(output + y * tileWidth, bitmapData + y * _bitmapWidth, tileWidth * sizeof(uint32_t));
+	}
+	return true;
+}
+
+uint32_t HdTileBitmapCache::AddBitmap(string filename)
+{
+	_bitmapFiles.push_back(filename);
+	return (uint32_t)_bitmapFiles.size() - 1;
+}
+
+uint32_t HdTileBitmapCache::GetBitmapCount()
+{
+	return (uint32_t)_bitmapFiles.size();
+}
+
+bool HdTileBitmapCache::DecodeTile(HdPackTileInfo* tile, uint32_t scale, vector<uint32_t> &output)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	output.resize(64 * scale * scale);
+	return LoadBitmap(tile->BitmapIndex) && CopyTile(tile, scale, output.data());
+}
+
+void HdTileBitmapCache::Initialize(vector<unique_ptr<HdPackTileInfo>> &tiles, uint32_t scale)
+{
+	_scale = scale;
+	_tilePixelCount = 64 * scale * scale;
+	_tiles.reset(new CachedTile[tiles.size()]);
+	for(size_t i = 0; i < tiles.size(); i++) {
+		CachedTile &entry = _tiles[i];
+		entry.Tile = tiles[i].get();
+		entry.Data.store(nullptr);
+		entry.LastUsedFrame.store(0);
+
+		tiles[i]->BitmapCache = this;
+		tiles[i]->CacheIndex = (uint32_t)i;
+	}
+
+	//The PNG files are loaded again as needed
+	_bitmapIndex = -1;
+	vector<uint32_t>().swap(_bitmapPixels);
+}
+
+uint32_t* HdTileBitmapCache::DecodeCachedTile(uint32_t index)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	CachedTile &entry = _tiles[index];
+	uint32_t* data = entry.Data.load(std::memory_order_relaxed);
+	if(data) {
+		//Decoded by another thread while this one was waiting
+		return data;
+	}
+
+	data = new uint32_t[_tilePixelCount];
+	if(!LoadBitmap(entry.Tile->BitmapIndex) || !CopyTile(entry.Tile, _scale, data)) {
+		//The PNG file can't be read anymore, draw the tile as transparent
+		memset(data, 0, _tilePixelCount * sizeof(uint32_t));
+	}
+
+	entry.Data.store(data, std::memory_order_release);
+	_decodedTiles.push_back(index);
+	_size += _tilePixelCount * sizeof(uint32_t);
+	return data;
+}
+
+void HdTileBitmapCache::OnFrameStart()
+{
+	//Called before the frame's scanlines are drawn, no tile data is in use
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_frame++;
+	if(_size <= _maxSize) {
+		return;
+	}
+
+	//Evict the least recently used tiles, down to 3/4 of the limit so this doesn't need to run on every frame
+	std::sort(_decodedTiles.begin(), _decodedTiles.end(), [this](uint32_t a, uint32_t b) {
+		return _tiles[a].LastUsedFrame.load(std::memory_order_relaxed) < _tiles[b].LastUsedFrame.load(std::memory_order_relaxed);
+	});
+
+	size_t targetSize = _maxSize / 4 * 3;
+	size_t evictCount = 0;
+	while(_size > targetSize && evictCount < _decodedTiles.size()) {
+		delete[] _tiles[_decodedTiles[evictCount]].Data.exchange(nullptr);
+		_size -= _tilePixelCount * sizeof(uint32_t);
+		evictCount++;
+	}
+	_decodedTiles.erase(_decodedTiles.begin(), _decodedTiles.begin() + evictCount);
+}
+
+size_t HdTileBitmapCache::GetSize()
+{
+	return _size;
+}
+
+uint32_t HdTileBitmapCache::GetDecodedTileCount()
+{
+	return (uint32_t)_decodedTiles.size();
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "stdafx.h"
+#include <atomic>
+#include <mutex>
+#include "../Utilities/ZipReader.h"
+
+struct HdPackTileInfo;
+
+//Decodes the HD pack's tile bitmaps when they are first drawn instead of at load time, and keeps the most recently used ones (up to a maximum size)
+//Decoded tiles are read without locking (the HD pack's scanlines are drawn by several threads), only decoding a tile locks the cache
+//Tiles are evicted between frames, so a single frame that uses more tiles than the limit allows can exceed it until the next frame starts
+class HdTileBitmapCache
+{
+private:
+	struct CachedTile
+	{
+		HdPackTileInfo* Tile = nullptr;
+		std::atomic<uint32_t*> Data;
+		std::atomic<uint32_t> LastUsedFrame;
+	};
+
+	string _packPath;
+	bool _loadFromZip = false;
+	ZipReader _reader;
+	vector<string> _bitmapFiles;
+
+	unique_ptr<CachedTile[]> _tiles;
+	vector<uint32_t> _decodedTiles;
+	uint32_t _scale = 1;
+	uint32_t _tilePixelCount = 0;
+	size_t _maxSize = 0;
+	size_t _size = 0;
+	uint32_t _frame = 0;
+	std::mutex _mutex;
+
+	//Last decoded PNG file, consecutive misses usually come from the same file
+	int32_t _bitmapIndex = -1;
+	vector<uint32_t> _bitmapPixels;
+	uint32_t _bitmapWidth = 0;
+	uint32_t _bitmapHeight = 0;
+
+	bool LoadFile(string filename, vector<uint8_t> &fileData);
+	bool LoadBitmap(uint32_t bitmapIndex);
+	bool CopyTile(HdPackTileInfo* tile, uint32_t scale, uint32_t* output);
+	uint32_t* DecodeCachedTile(uint32_t index);
+
+public:
+	HdTileBitmapCache(string packPath, bool loadFromZip, size_t maxSize);
+	~HdTileBitmapCache();
+
+	HdTileBitmapCache(const HdTileBitmapCache&) = delete;
+	HdTileBitmapCache& operator=(const HdTileBitmapCache&) = delete;
+
+	uint32_t AddBitmap(string filename);
+	uint32_t GetBitmapCount();
+
+	//Used while loading the pack (to compute the tile's flags), the result is not cached
+	bool DecodeTile(HdPackTileInfo* tile, uint32_t scale, vector<uint32_t> &output);
+
+	void Initialize(vector<unique_ptr<HdPackTileInfo>> &tiles, uint32_t scale);
+	void OnFrameStart();
+
+	size_t GetSize();
+	uint32_t GetDecodedTileCount();
+
+	__forceinline uint32_t* GetTileData(uint32_t index)
+	{
+		CachedTile &entry = _tiles[index];
+		if(entry.LastUsedFrame.load(std::memory_order_relaxed) != _frame) {
+			entry.LastUsedFrame.store(_frame, std::memory_order_relaxed);
+		}
+
+		uint32_t* data = entry.Data.load(std::memory_order_acquire);
+		return data ? data : DecodeCachedTile(index);
+	}
+};
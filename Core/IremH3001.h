@@ -28,6 +28,8 @@ protected:
 		Stream(_irqEnabled, _irqCounter, _irqReloadValue);
 	}
 
+	virtual bool RequiresCpuClock() override { return true; }
+
 	virtual void ProcessCpuClock() override
 	{
 		if(_irqEnabled) {
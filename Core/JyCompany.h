@@ -56,6 +56,7 @@ private:
 protected:
 	virtual uint16_t GetPRGPageSize() override { return 0x2000; }
 	virtual uint16_t GetCHRPageSize() override { return 0x0400; }
+	virtual bool RequiresPpuSync() override { return true; }
 	virtual bool AllowRegisterRead() override { return true; }
 
 	void InitMapper() override
@@ -344,6 +345,8 @@ protected:
 		UpdateState();
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		if(_irqSource == JyIrqSource::CpuClock || (_irqSource == JyIrqSource::CpuWrite && _console->GetCpu()->IsCpuWrite())) {
@@ -44,6 +44,8 @@ protected:
 		SetMirroringType(_mirroring);
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		if(_irqEnabled && _irqCounter) {
@@ -26,6 +26,8 @@ protected:
 		Stream(_initState, _irqCounter, _irqEnabled);
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		if(_irqEnabled) {
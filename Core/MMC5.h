@@ -221,6 +221,8 @@ private:
 		}
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		_audio->Clock();
@@ -287,6 +289,7 @@ private:
 	{
 		_fillModeTile = tile;
 		memset(GetNametable(NtFillModeIndex), tile, 32 * 30); //32 tiles per row, 30 rows
+		MarkRamModified(GetNametable(NtFillModeIndex), 32 * 30);
 	}
 
 	void SetFillModeColor(uint8_t color)
@@ -294,11 +297,13 @@ private:
 		_fillModeColor = color;
 		uint8_t attributeByte = color | color << 2 | color << 4 | color << 6;
 		memset(GetNametable(NtFillModeIndex) + 32 * 30, attributeByte, 64); //Attribute table is 64 bytes
+		MarkRamModified(GetNametable(NtFillModeIndex) + 32 * 30, 64);
 	}
 
 protected:
 	virtual uint16_t GetPRGPageSize() override { return 0x2000; }
 	virtual uint16_t GetCHRPageSize() override { return 0x400; }
+	virtual bool RequiresPpuSync() override { return true; }
 	virtual uint16_t RegisterStartAddress() override { return 0x5000; }
 	virtual uint16_t RegisterEndAddress() override { return 0x5206; }
 	virtual uint32_t GetSaveRamPageSize() override { return 0x2000; }
@@ -395,6 +400,7 @@ protected:
 		_splitTileNumber = -1;
 
 		memset(GetNametable(NtEmptyIndex), 0, BaseMapper::NametableSize);
+		MarkRamModified(GetNametable(NtEmptyIndex), BaseMapper::NametableSize);
 
 		SetExtendedRamMode(0);
 
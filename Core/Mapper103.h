@@ -50,6 +50,7 @@ protected:
 			case 0x6000: case 0x7000:
 				//Workram is always writeable, even when PRG ROM is mapped to $6000
 				_workRam[addr - 0x6000] = value;
+				MarkRamModified(_workRam + addr - 0x6000, 1);
 				break;
 
 			case 0x8000:
@@ -61,6 +62,7 @@ protected:
 				//Workram is always writeable, even when PRG ROM is mapped to $B800-$D7FF
 				if(addr >= 0xB800 && addr < 0xD800) {
 					_workRam[0x2000 + addr - 0xB800] = value;
+					MarkRamModified(_workRam + 0x2000 + addr - 0xB800, 1);
 				}
 				break;
 
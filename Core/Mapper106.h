@@ -29,6 +29,8 @@ protected:
 		Stream(_irqCounter, _irqEnabled);
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		if(_irqEnabled) {
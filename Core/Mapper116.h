@@ -32,6 +32,7 @@ protected:
 	virtual uint16_t RegisterEndAddress() override { return 0xFFFF; }
 	virtual uint16_t GetPRGPageSize() override { return 0x2000; }
 	virtual uint16_t GetCHRPageSize() override { return 0x400; }
+	virtual bool RequiresPpuSync() override { return true; }
 
 	void InitMapper() override
 	{
@@ -78,6 +78,8 @@ protected:
 		}
 	}
 
+	virtual bool RequiresCpuClock() override { return true; }
+
 	virtual void ProcessCpuClock() override
 	{
 		if(_needIrq) {
@@ -33,6 +33,7 @@ MemoryManager::~MemoryManager()
 void MemoryManager::SetMapper(std::shared_ptr<BaseMapper> mapper)
 {
 	_mapper = mapper;
+	UpdateDirectReadPages();
 }
 
 void MemoryManager::Reset(bool softReset)
@@ -61,6 +62,7 @@ void MemoryManager::RegisterIODevice(IMemoryHandler *handler)
 
 	InitializeMemoryHandlers(_ramReadHandlers, handler, ranges.GetRAMReadAddresses(), ranges.GetAllowOverride());
 	InitializeMemoryHandlers(_ramWriteHandlers, handler, ranges.GetRAMWriteAddresses(), ranges.GetAllowOverride());
+	UpdatePageReadHandlers();
 }
 
 void MemoryManager::RegisterWriteHandler(IMemoryHandler* handler, uint32_t start, uint32_t end)
@@ -82,6 +84,38 @@ void MemoryManager::UnregisterIODevice(IMemoryHandler *handler)
 	for(uint16_t address : *ranges.GetRAMWriteAddresses()) {
 		_ramWriteHandlers[address] = &_openBusHandler;
 	}
+	UpdatePageReadHandlers();
+}
+
+void MemoryManager::UpdatePageReadHandlers()
+{
+	for(int i = 0; i < 0x100; i++) {
+		IMemoryHandler* handler = _ramReadHandlers[i << 8];
+		for(int j = 1; j < 0x100; j++) {
+			if(_ramReadHandlers[(i << 8) | j] != handler) {
+				handler = nullptr;
+				break;
+			}
+		}
+		_pageReadHandlers[i] = handler;
+	}
+	UpdateDirectReadPages();
+}
+
+void MemoryManager::UpdateDirectReadPages(uint8_t startPage, uint8_t endPage)
+{
+	CheatManager* cheatManager = _console->GetCheatManager();
+	for(int i = startPage; i <= endPage; i++) {
+		uint8_t* page = nullptr;
+		if(!cheatManager->HasCodeInPage(i)) {
+			if(_pageReadHandlers[i] == &_internalRamHandler) {
+				page = _internalRAM + ((i << 8) & (MemoryManager::InternalRAMSize - 1));
+			} else if(_mapper && _pageReadHandlers[i] == _mapper.get()) {
+				page = _mapper->GetDirectReadPage(i);
+			}
+		}
+		_directReadPages[i] = page;
+	}
 }
 
 uint8_t* MemoryManager::GetInternalRAM()
@@ -118,13 +152,10 @@ uint16_t MemoryManager::DebugReadWord(uint16_t addr)
 	return DebugRead(addr) | (DebugRead(addr + 1) << 8);
 }
 
-uint8_t MemoryManager::Read(uint16_t addr, MemoryOperationType operationType)
+uint8_t MemoryManager::ReadFromHandler(uint16_t addr)
 {
 	uint8_t value = _ramReadHandlers[addr]->ReadRAM(addr);
 	_console->GetCheatManager()->ApplyCodes(addr, value);
-
-	_openBusHandler.SetOpenBus(value);
-
 	return value;
 }
 
@@ -26,7 +26,14 @@ class MemoryManager : public Snapshotable
 		IMemoryHandler** _ramReadHandlers;
 		IMemoryHandler** _ramWriteHandlers;
 
+		//Handler that reads every address of each 256-byte page (nullptr when a page is shared by multiple handlers)
+		IMemoryHandler* _pageReadHandlers[0x100];
+		//Pages that can be read directly, without calling their handler (internal RAM, PRG ROM/RAM pages without registers or cheats)
+		uint8_t* _directReadPages[0x100];
+
 		void InitializeMemoryHandlers(IMemoryHandler** memoryHandlers, IMemoryHandler* handler, vector<uint16_t> *addresses, bool allowOverride);
+		void UpdatePageReadHandlers();
+		uint8_t ReadFromHandler(uint16_t addr);
 
 	protected:
 		void StreamState(bool saving) override;
@@ -50,7 +57,16 @@ class MemoryManager : public Snapshotable
 
 		uint8_t* GetInternalRAM();
 
-		uint8_t Read(uint16_t addr, MemoryOperationType operationType = MemoryOperationType::Read);
+		void UpdateDirectReadPages(uint8_t startPage = 0, uint8_t endPage = 0xFF);
+
+		__forceinline uint8_t Read(uint16_t addr, MemoryOperationType operationType = MemoryOperationType::Read)
+		{
+			uint8_t* page = _directReadPages[addr >> 8];
+			uint8_t value = page ? page[(uint8_t)addr] : ReadFromHandler(addr);
+			_openBusHandler.SetOpenBus(value);
+			return value;
+		}
+
 		void Write(uint16_t addr, uint8_t value, MemoryOperationType operationType);
 
 		uint32_t ToAbsolutePrgAddress(uint16_t ramAddr);
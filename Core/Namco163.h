@@ -30,6 +30,11 @@ private:
 	{
 		if(_autoDetectVariant) {
 			if(!_notNamco340 || variant != NamcoVariant::Namco340) {
+				if(_variant != variant) {
+					//Bring the audio up to date before it is enabled/disabled
+					_console->GetApu()->Run();
+					_audio->SetSoundChipPresent(variant == NamcoVariant::Namco163);
+				}
 				_variant = variant;
 			}
 		}
@@ -98,6 +103,7 @@ protected:
 
 		SelectPRGPage(3, -1);
 		UpdateSaveRamAccess();
+		_audio->SetSoundChipPresent(_variant == NamcoVariant::Namco163);
 	}
 	
 	void StreamState(bool saving) override
@@ -108,6 +114,7 @@ protected:
 		Stream(_variant, _notNamco340, _autoDetectVariant, _writeProtect, _lowChrNtMode, _highChrNtMode, _irqCounter, audio);
 		if(!saving) {
 			UpdateSaveRamAccess();
+			_audio->SetSoundChipPresent(_variant == NamcoVariant::Namco163);
 		}
 	}
 
@@ -133,6 +140,8 @@ protected:
 		}
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		if(_irqCounter & 0x8000 && (_irqCounter & 0x7FFF) != 0x7FFF) {
@@ -141,10 +150,6 @@ protected:
 				_console->GetCpu()->SetIrqSource(IRQSource::External);
 			}
 		}
-
-		if(_variant == NamcoVariant::Namco163) {
-			_audio->Clock();
-		}
 	}
 
 	void WriteRAM(uint16_t addr, uint8_t value) override
@@ -18,6 +18,7 @@ private:
 	int8_t _currentChannel;
 	int16_t _lastOutput;
 	bool _disableSound;
+	bool _soundChipPresent;
 
 	enum SoundReg
 	{
@@ -75,7 +76,7 @@ private:
 		return (_internalRam[0x7F] >> 4) & 0x07;
 	}
 
-	void UpdateChannel(int channel)
+	void UpdateChannel(int channel, uint32_t cycle)
 	{
 		uint32_t phase = GetPhase(channel);
 		uint32_t freq = GetFrequency(channel);
@@ -98,11 +99,11 @@ private:
 		}
 
 		_channelOutput[channel] = (sample - 8) * volume;
-		UpdateOutputLevel();
+		UpdateOutputLevel(cycle);
 		SetPhase(channel, phase);
 	}
 
-	void UpdateOutputLevel()
+	void UpdateOutputLevel(uint32_t cycle)
 	{
 		int16_t summedOutput = 0;
 		for(int i = 7, min = 7 - GetNumberOfChannels(); i >= min; i--) {
@@ -110,7 +111,7 @@ private:
 		}
 		summedOutput /= GetNumberOfChannels() + 1;
 
-		_console->GetApu()->AddExpansionAudioDelta(AudioChannel::Namco163, summedOutput - _lastOutput);
+		_console->GetApu()->AddExpansionAudioDelta(AudioChannel::Namco163, summedOutput - _lastOutput, cycle);
 		_lastOutput = summedOutput;
 	}
 
@@ -124,18 +125,28 @@ protected:
 		Stream(internalRam, channelOutput, _ramPosition, _autoIncrement, _updateCounter, _currentChannel, _lastOutput, _disableSound);
 	}
 
-	void ClockAudio() override
+	void RunAudio(uint32_t startCycle, uint32_t endCycle) override
 	{
-		if(!_disableSound) {
-			_updateCounter++;
-			if(_updateCounter == 15) {
-				UpdateChannel(_currentChannel);
+		if(_disableSound || !_soundChipPresent) {
+			return;
+		}
 
-				_updateCounter = 0;
-				_currentChannel--;
-				if(_currentChannel < 7 - GetNumberOfChannels()) {
-					_currentChannel = 7;
-				}
+		//A channel is updated every 15 cycles, skip directly to the cycles where this happens
+		uint32_t cycle = startCycle;
+		while(cycle < endCycle) {
+			uint32_t cyclesToUpdate = (uint8_t)(14 - _updateCounter) + 1;
+			if(cycle + cyclesToUpdate > endCycle) {
+				_updateCounter += endCycle - cycle;
+				break;
+			}
+
+			cycle += cyclesToUpdate;
+			UpdateChannel(_currentChannel, cycle - 1);
+
+			_updateCounter = 0;
+			_currentChannel--;
+			if(_currentChannel < 7 - GetNumberOfChannels()) {
+				_currentChannel = 7;
 			}
 		}
 	}
@@ -151,6 +162,14 @@ public:
 		_currentChannel = 7;
 		_lastOutput = 0;
 		_disableSound = false;
+		_soundChipPresent = true;
+		_console->GetApu()->SetExpansionAudio(this);
+	}
+
+	void SetSoundChipPresent(bool present)
+	{
+		//Only the 163 has the sound chip (the mapper's variant can be auto-detected at run time)
+		_soundChipPresent = present;
 	}
 
 	uint8_t* GetInternalRam()
@@ -160,6 +179,7 @@ public:
 
 	void WriteRegister(uint16_t addr, uint8_t value)
 	{
+		_console->GetApu()->Run();
 		switch(addr & 0xF800) {
 			case 0x4800:
 				_internalRam[_ramPosition] = value;
@@ -180,6 +200,7 @@ public:
 
 	uint8_t ReadRegister(uint16_t addr)
 	{
+		_console->GetApu()->Run();
 		uint8_t value = 0;
 		switch(addr & 0xF800) {
 			case 0x4800: {
@@ -9,7 +9,10 @@ NtscFilter::NtscFilter(shared_ptr<Console> console) : BaseVideoFilter(console)
 	memset(_palette, 0, sizeof(_palette));
 	memset(&_ntscData, 0, sizeof(_ntscData));
 	_ntscSetup = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
-	_ntscBuffer = new uint32_t[NES_NTSC_OUT_WIDTH(256) * 240];
+	for(int i = 0; i < 2; i++) {
+		_ntscBuffer[i] = new uint32_t[NES_NTSC_OUT_WIDTH(256) * 240];
+		_ppuOutputCache[i] = new uint16_t[256 * 240];
+	}
 }
 
 FrameInfo NtscFilter::GetFrameInfo()
@@ -85,13 +88,42 @@ void NtscFilter::OnBeforeApplyFilter()
 		}
 
 		nes_ntsc_init(&_ntscData, &_ntscSetup);
+		_ntscBufferValid[0] = _ntscBufferValid[1] = false;
 	}
 }
 
 void NtscFilter::ApplyFilter(uint16_t *ppuOutputBuffer)
 {
-	nes_ntsc_blit(&_ntscData, ppuOutputBuffer, PPU::ScreenWidth, IsOddFrame() ? 0 : 1, PPU::ScreenWidth, 240, _ntscBuffer, NES_NTSC_OUT_WIDTH(PPU::ScreenWidth)*4);
-	GenerateArgbFrame(_ntscBuffer);
+	int burstPhase = IsOddFrame() ? 0 : 1;
+	uint32_t* ntscBuffer = _ntscBuffer[burstPhase];
+	uint16_t* ppuOutputCache = _ppuOutputCache[burstPhase];
+	bool cacheValid = _ntscBufferValid[burstPhase];
+	int rowWidth = NES_NTSC_OUT_WIDTH(PPU::ScreenWidth);
+
+	auto rowChanged = [=](int row) {
+		//The buffer contains the emphasis bits, so they are compared too
+		return !cacheValid || memcmp(ppuOutputBuffer + row * PPU::ScreenWidth, ppuOutputCache + row * PPU::ScreenWidth, PPU::ScreenWidth * sizeof(uint16_t)) != 0;
+	};
+
+	int row = 0;
+	while(row < PPU::ScreenHeight) {
+		if(!rowChanged(row)) {
+			row++;
+			continue;
+		}
+
+		//Blit consecutive modified rows together
+		int firstRow = row;
+		do {
+			row++;
+		} while(row < PPU::ScreenHeight && rowChanged(row));
+
+		memcpy(ppuOutputCache + firstRow * PPU::ScreenWidth, ppuOutputBuffer + firstRow * PPU::ScreenWidth, (row - firstRow) * PPU::ScreenWidth * sizeof(uint16_t));
+		nes_ntsc_blit(&_ntscData, ppuOutputBuffer + firstRow * PPU::ScreenWidth, PPU::ScreenWidth, (burstPhase + firstRow) % nes_ntsc_burst_count, PPU::ScreenWidth, row - firstRow, ntscBuffer + firstRow * rowWidth, rowWidth * 4);
+	}
+	_ntscBufferValid[burstPhase] = true;
+
+	GenerateArgbFrame(ntscBuffer);
 }
 
 void NtscFilter::GenerateArgbFrame(uint32_t *ntscBuffer)
@@ -114,6 +146,9 @@ void NtscFilter::GenerateArgbFrame(uint32_t *ntscBuffer)
 		double scanlineIntensity = 1.0 - _console->GetSettings()->GetPictureSettings().ScanlineIntensity;
 		bool verticalBlend = _console->GetSettings()->GetNtscFilterSettings().VerticalBlend;
 
+		uint8_t scanlineLut[256];
+		InitScanlineLut(scanlineLut, scanlineIntensity);
+
 		for(int y = PPU::ScreenHeight - 1 - overscan.Bottom; y >= (int)overscan.Top; y--) {
 			uint32_t const* in = ntscBuffer + y * rowWidth;
 			uint32_t* out = outputBuffer + (y - overscan.Top) * 2 * rowWidthOverscan;
@@ -134,11 +169,7 @@ void NtscFilter::GenerateArgbFrame(uint32_t *ntscBuffer)
 					}
 
 					if(scanlineIntensity < 1.0) {
-						uint8_t r = (mixed >> 16) & 0xFF, g = (mixed >> 8) & 0xFF, b = mixed & 0xFF;
-						r = (uint8_t)(r * scanlineIntensity);
-						g = (uint8_t)(g * scanlineIntensity);
-						b = (uint8_t)(b * scanlineIntensity);
-						*(out + rowWidthOverscan) = 0xFF000000 | (r << 16) | (g << 8) | b;
+						*(out + rowWidthOverscan) = ApplyScanlineLut(scanlineLut, mixed);
 					} else {
 						*(out + rowWidthOverscan) = 0xFF000000 | mixed;
 					}
@@ -157,5 +188,8 @@ void NtscFilter::GenerateArgbFrame(uint32_t *ntscBuffer)
 
 NtscFilter::~NtscFilter()
 {
-	delete[] _ntscBuffer;
+	for(int i = 0; i < 2; i++) {
+		delete[] _ntscBuffer[i];
+		delete[] _ppuOutputCache[i];
+	}
 }
\ No newline at end of file
@@ -12,7 +12,12 @@ private:
 	nes_ntsc_t _ntscData;
 	bool _keepVerticalRes = false;
 	uint8_t _palette[512 * 3];
-	uint32_t* _ntscBuffer;
+
+	//Each row's burst phase only depends on the frame's parity, so odd and even frames each keep
+	//the last input they received and its output - rows that didn't change are not blitted again
+	uint32_t* _ntscBuffer[2];
+	uint16_t* _ppuOutputCache[2];
+	bool _ntscBufferValid[2] = { false, false };
 
 	void GenerateArgbFrame(uint32_t *outputBuffer);
 
@@ -55,6 +55,36 @@ namespace Vrc7Opll
 		uint32_t TL, FB, EG, ML, AR, DR, SL, RR, KR, KL, AM, PM, WF;
 	};
 
+	/* Slot data used to generate each sample, stored by lane so all slots can be processed at once (see OpllEmulator::calc) */
+	/* Modulators use lanes 0-5, carriers use lanes 8-13 - the remaining lanes are padding and stay in the FINISH state */
+	struct OpllLanes
+	{
+		static const int Count = 16;
+
+		uint32_t phase[Count];
+		uint32_t dphase[Count];
+		uint32_t pgout[Count];
+		int32_t eg_mode[Count];
+		uint32_t eg_phase[Count];
+		uint32_t eg_dphase[Count];
+		uint32_t egout[Count];
+		uint32_t tll[Count];
+		int32_t output0[Count];
+		int32_t output1[Count];
+		int32_t feedback[Count];
+
+		/* Copy of the patch values needed by calc (masks are 0 or 0xFFFFFFFF) */
+		uint32_t pm_mask[Count];
+		uint32_t am_mask[Count];
+		uint32_t fb_mask[Count];
+		uint32_t fb_shift[Count];
+		uint32_t eg_mask[Count];
+		uint32_t ar_max_mask[Count];
+		uint32_t sl[Count];
+		uint16_t *sintbl[Count];   /* Wavetable */
+		uint32_t wf_offset[Count]; /* Wavetable's offset in OpllTables::SINTABLE32 */
+	};
+
 	class OpllChannel : public Snapshotable
 	{
 	private:
@@ -70,17 +100,6 @@ namespace Vrc7Opll
 			return c >> b;
 		}
 
-		int32_t wave2_4pi(int32_t e)
-		{
-			return (e) >> (SLOT_AMP_BITS - PG_BITS - 1);
-		}
-
-		/* Convert Amp(0 to EG_HEIGHT) to Phase(0 to 8PI). */
-		int32_t wave2_8pi(int32_t e)
-		{
-			return e >> (SLOT_AMP_BITS - PG_BITS - 2);
-		}
-
 		int32_t EG2DB(int32_t d)
 		{
 			return d*(int32_t)(EG_STEP / DB_STEP);
@@ -97,36 +116,42 @@ namespace Vrc7Opll
 		}
 
 		shared_ptr<OpllTables> _tables;
-		OpllPatch patch;
+		OpllPatch patch = {};
 
 		int32_t type;          /* 0 : modulator 1 : carrier */
 
-									  /* OUTPUT */
-		int32_t feedback;
-		int32_t output[2];   /* Output value of slot */
-
-									/* for Phase Generator (PG) */
-		uint16_t *sintbl;    /* Wavetable */
-		uint32_t phase;      /* Phase */
-		uint32_t dphase;     /* Phase increment amount */
-		uint32_t pgout;      /* output */
-
 									/* for Envelope Generator (EG) */
 		int32_t fnum;          /* F-Number */
 		int32_t block;         /* Block */
 		int32_t volume;        /* Current volume */
 		int32_t sustine;       /* Sustine 1 = ON, 0 = OFF */
-		uint32_t tll;	      /* Total Level + Key scale level*/
 		uint32_t rks;        /* Key scale offset (Rks) */
-		int32_t eg_mode;       /* Current state */
-		uint32_t eg_phase;   /* Phase */
-		uint32_t eg_dphase;  /* Phase increment amount */
-		uint32_t egout;      /* output */
+
+		/* The rest of the slot's state is in its lane */
+		OpllLanes *_lanes;
+		size_t _lane;
+
+									  /* OUTPUT */
+		int32_t& feedback() { return _lanes->feedback[_lane]; }
+		int32_t& output0() { return _lanes->output0[_lane]; }   /* Output value of slot */
+		int32_t& output1() { return _lanes->output1[_lane]; }
+
+									/* for Phase Generator (PG) */
+		uint32_t& phase() { return _lanes->phase[_lane]; }      /* Phase */
+		uint32_t& dphase() { return _lanes->dphase[_lane]; }     /* Phase increment amount */
+		uint32_t& pgout() { return _lanes->pgout[_lane]; }      /* output */
+
+		uint32_t& tll() { return _lanes->tll[_lane]; }	      /* Total Level + Key scale level*/
+		int32_t& eg_mode() { return _lanes->eg_mode[_lane]; }       /* Current state */
+		uint32_t& eg_phase() { return _lanes->eg_phase[_lane]; }   /* Phase */
+		uint32_t& eg_dphase() { return _lanes->eg_dphase[_lane]; }  /* Phase increment amount */
+		uint32_t& egout() { return _lanes->egout[_lane]; }      /* output */
+		uint16_t*& sintbl() { return _lanes->sintbl[_lane]; }
 
 	protected:
 		void StreamState(bool saving) override
 		{
-			Stream(type, feedback, output[0], output[1], phase, dphase, pgout, fnum, block, volume, sustine, tll, rks, eg_mode, eg_phase, eg_dphase, egout,
+			Stream(type, feedback(), output0(), output1(), phase(), dphase(), pgout(), fnum, block, volume, sustine, tll(), rks, eg_mode(), eg_phase(), eg_dphase(), egout(),
 				patch.TL, patch.FB, patch.EG, patch.ML, patch.AR, patch.DR, patch.SL, patch.RR, patch.KR, patch.KL, patch.AM, patch.PM, patch.WF);
 
 			if(!saving) {
@@ -147,7 +172,7 @@ namespace Vrc7Opll
 
 		int32_t GetEgMode()
 		{
-			return eg_mode;
+			return eg_mode();
 		}
 
 		void SetTables(shared_ptr<OpllTables> tables)
@@ -155,6 +180,12 @@ namespace Vrc7Opll
 			_tables = tables;
 		}
 
+		void SetLane(OpllLanes *lanes, size_t lane)
+		{
+			_lanes = lanes;
+			_lane = lane;
+		}
+
 		void setSustine(int32_t sustine)
 		{
 			this->sustine = sustine;
@@ -178,47 +209,49 @@ namespace Vrc7Opll
 		void reset(int type)
 		{
 			this->type = type;
-			sintbl = _tables->waveform[0];
-			phase = 0;
-			dphase = 0;
-			output[0] = 0;
-			output[1] = 0;
-			feedback = 0;
-			eg_mode = SETTLE;
-			eg_phase = EG_DP_WIDTH;
-			eg_dphase = 0;
+			sintbl() = _tables->waveform[0];
+			_lanes->wf_offset[_lane] = 0;
+			phase() = 0;
+			dphase() = 0;
+			output0() = 0;
+			output1() = 0;
+			feedback() = 0;
+			eg_mode() = SETTLE;
+			eg_phase() = EG_DP_WIDTH;
+			eg_dphase() = 0;
 			rks = 0;
-			tll = 0;
+			tll() = 0;
 			sustine = 0;
 			fnum = 0;
 			block = 0;
 			volume = 0;
-			pgout = 0;
-			egout = 0;
+			pgout() = 0;
+			egout() = 0;
+			UpdatePatch();
 		}
 
 		/* Slot key on	*/
 		void slotOn()
 		{
-			eg_mode = ATTACK;
-			eg_phase = 0;
-			phase = 0;
+			eg_mode() = ATTACK;
+			eg_phase() = 0;
+			phase() = 0;
 		}
 
 		/* Slot key on without reseting the phase */
 		void slotOn2()
 		{
-			eg_mode = ATTACK;
-			eg_phase = 0;
+			eg_mode() = ATTACK;
+			eg_phase() = 0;
 		}
 
 		/* Slot key off */
 		void slotOff()
 		{
-			if(eg_mode == ATTACK) {
-				eg_phase = ExpandBits(_tables->AR_ADJUST_TABLE[GetHighBits(eg_phase, EG_DP_BITS - EG_BITS)], EG_BITS, EG_DP_BITS);
+			if(eg_mode() == ATTACK) {
+				eg_phase() = ExpandBits(_tables->AR_ADJUST_TABLE[GetHighBits(eg_phase(), EG_DP_BITS - EG_BITS)], EG_BITS, EG_DP_BITS);
 			}
-			eg_mode = RELEASE;
+			eg_mode() = RELEASE;
 		}
 
 		void setSlotVolume(int32_t volume)
@@ -228,61 +261,46 @@ namespace Vrc7Opll
 
 		void calc_phase(int32_t lfo)
 		{
+			uint32_t &phase = this->phase();
 			if(patch.PM) {
-				phase += (dphase * lfo) >> PM_AMP_BITS;
+				phase += (dphase() * lfo) >> PM_AMP_BITS;
 			} else {
-				phase += dphase;
+				phase += dphase();
 			}
 
 			phase &= (DP_WIDTH - 1);
 
-			pgout = GetHighBits(phase, DP_BASE_BITS);
+			pgout() = GetHighBits(phase, DP_BASE_BITS);
 		}
 
-		int32_t calc_slot_car(int32_t fm)
+		/* Must be called after the patch is modified */
+		void UpdatePatch()
 		{
-			output[1] = output[0];
-
-			if(egout >= (DB_MUTE - 1)) {
-				output[0] = 0;
-			} else {
-				output[0] = _tables->DB2LIN_TABLE[sintbl[(pgout + wave2_8pi(fm))&(PG_WIDTH - 1)] + egout];
-			}
-
-			return (output[1] + output[0]) >> 1;
-		}
-
-		int32_t calc_slot_mod()
-		{
-			int32_t fm;
-
-			output[1] = output[0];
-
-			if(egout >= (DB_MUTE - 1)) {
-				output[0] = 0;
-			} else if(patch.FB != 0) {
-				fm = wave2_4pi(feedback) >> (7 - patch.FB);
-				output[0] = _tables->DB2LIN_TABLE[sintbl[(pgout + fm)&(PG_WIDTH - 1)] + egout];
-			} else {
-				output[0] = _tables->DB2LIN_TABLE[sintbl[pgout] + egout];
-			}
-
-			feedback = (output[1] + output[0]) >> 1;
+			static uint32_t SL[16] = {
+				S2E(0.0), S2E(3.0), S2E(6.0), S2E(9.0), S2E(12.0), S2E(15.0), S2E(18.0), S2E(21.0),
+				S2E(24.0), S2E(27.0), S2E(30.0), S2E(33.0), S2E(36.0), S2E(39.0), S2E(42.0), S2E(48.0)
+			};
 
-			return feedback;
+			_lanes->pm_mask[_lane] = patch.PM ? 0xFFFFFFFF : 0;
+			_lanes->am_mask[_lane] = patch.AM ? 0xFFFFFFFF : 0;
+			_lanes->fb_mask[_lane] = patch.FB ? 0xFFFFFFFF : 0;
+			_lanes->fb_shift[_lane] = 7 - (patch.FB & 7);
+			_lanes->eg_mask[_lane] = patch.EG ? 0xFFFFFFFF : 0;
+			_lanes->ar_max_mask[_lane] = patch.AR == 15 ? 0xFFFFFFFF : 0;
+			_lanes->sl[_lane] = SL[patch.SL & 0x0F];
 		}
 
 		void UpdatePg()
 		{
-			dphase = _tables->dphaseTable[fnum][block][patch.ML];
+			dphase() = _tables->dphaseTable[fnum][block][patch.ML];
 		}
 
 		void UpdateTll()
 		{
 			if(type == 0) {
-				tll = _tables->tllTable[(fnum) >> 5][block][patch.TL][patch.KL];
+				tll() = _tables->tllTable[(fnum) >> 5][block][patch.TL][patch.KL];
 			} else {
-				tll = _tables->tllTable[(fnum) >> 5][block][volume][patch.KL];
+				tll() = _tables->tllTable[(fnum) >> 5][block][volume][patch.KL];
 			}
 		}
 
@@ -293,16 +311,18 @@ namespace Vrc7Opll
 
 		void UpdateWf()
 		{
-			sintbl = _tables->waveform[patch.WF];
+			sintbl() = _tables->waveform[patch.WF];
+			_lanes->wf_offset[_lane] = patch.WF ? PG_WIDTH : 0;
 		}
 
 		void UpdateEg()
 		{
-			eg_dphase = calc_eg_dphase();
+			eg_dphase() = calc_eg_dphase();
 		}
 
 		void UpdateAll()
 		{
+			UpdatePatch();
 			UpdatePg();
 			UpdateTll();
 			UpdateRks();
@@ -312,7 +332,7 @@ namespace Vrc7Opll
 		
 		uint32_t calc_eg_dphase()
 		{
-			switch(eg_mode) {
+			switch(eg_mode()) {
 				case ATTACK:
 					return _tables->dphaseARTable[patch.AR][rks];
 
@@ -344,18 +364,16 @@ namespace Vrc7Opll
 
 		void calc_envelope(int32_t lfo)
 		{
-			static uint32_t SL[16] = {
-				S2E(0.0), S2E(3.0), S2E(6.0), S2E(9.0), S2E(12.0), S2E(15.0), S2E(18.0), S2E(21.0),
-				S2E(24.0), S2E(27.0), S2E(30.0), S2E(33.0), S2E(36.0), S2E(39.0), S2E(42.0), S2E(48.0)
-			};
-
+			int32_t &eg_mode = this->eg_mode();
+			uint32_t &eg_phase = this->eg_phase();
+			uint32_t sl = _lanes->sl[_lane];
 			uint32_t egout;
 
 			switch(eg_mode) {
 
 				case ATTACK:
 					egout = _tables->AR_ADJUST_TABLE[GetHighBits(eg_phase, EG_DP_BITS - EG_BITS)];
-					eg_phase += eg_dphase;
+					eg_phase += eg_dphase();
 					if((EG_DP_WIDTH & eg_phase) || (patch.AR == 15)) {
 						egout = 0;
 						eg_phase = 0;
@@ -367,14 +385,14 @@ namespace Vrc7Opll
 
 				case DECAY:
 					egout = GetHighBits(eg_phase, EG_DP_BITS - EG_BITS);
-					eg_phase += eg_dphase;
-					if(eg_phase >= SL[patch.SL]) {
+					eg_phase += eg_dphase();
+					if(eg_phase >= sl) {
 						if(patch.EG) {
-							eg_phase = SL[patch.SL];
+							eg_phase = sl;
 							eg_mode = SUSHOLD;
 							UpdateEg();
 						} else {
-							eg_phase = SL[patch.SL];
+							eg_phase = sl;
 							eg_mode = SUSTINE;
 							UpdateEg();
 						}
@@ -392,7 +410,7 @@ namespace Vrc7Opll
 				case SUSTINE:
 				case RELEASE:
 					egout = GetHighBits(eg_phase, EG_DP_BITS - EG_BITS);
-					eg_phase += eg_dphase;
+					eg_phase += eg_dphase();
 					if(egout >= (1 << EG_BITS)) {
 						eg_mode = FINISH;
 						egout = (1 << EG_BITS) - 1;
@@ -409,16 +427,16 @@ namespace Vrc7Opll
 			}
 
 			if(patch.AM) {
-				egout = EG2DB(egout + tll) + lfo;
+				egout = EG2DB(egout + tll()) + lfo;
 			} else {
-				egout = EG2DB(egout + tll);
+				egout = EG2DB(egout + tll());
 			}
 
 			if(egout >= DB_MUTE) {
 				egout = DB_MUTE - 1;
 			}
 
-			this->egout = egout;
+			this->egout() = egout;
 		}
 	};
-}
+}
\ No newline at end of file
@@ -48,6 +48,11 @@ YM2143 data sheet
 #include "OpllTables.h"
 #include "OpllChannel.h"
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	#include <immintrin.h>
+	#define OPLL_AVX2
+#endif
+
 namespace Vrc7Opll
 {
 	class OpllEmulator : public Snapshotable
@@ -103,6 +108,10 @@ namespace Vrc7Opll
 
 		/* Slot */
 		OpllChannel slot[6 * 2];
+		OpllLanes lanes;
+
+		/* Process all slots at once with AVX2 (when supported by the CPU) */
+		bool simdEnabled = false;
 
 		uint32_t mask = 0;
 		shared_ptr<OpllTables> tables;
@@ -117,6 +126,12 @@ namespace Vrc7Opll
 			return &slot[(i << 1) | 1];
 		}
 
+		/* Modulators are in lanes 0-5, carriers in lanes 8-13 */
+		int GetLane(int slotIndex)
+		{
+			return (slotIndex & 1) * 8 + (slotIndex >> 1);
+		}
+
 		int32_t OPLL_MASK_CH(int32_t x)
 		{
 			return 1 << x;
@@ -166,10 +181,21 @@ namespace Vrc7Opll
 			tables.reset(new Vrc7Opll::OpllTables());
 			tables->maketables(3579545, 49716);
 
+			memset(&lanes, 0, sizeof(lanes));
+			for(int i = 0; i < OpllLanes::Count; i++) {
+				lanes.eg_mode[i] = FINISH;
+				lanes.egout[i] = DB_MUTE - 1;
+			}
+
 			for(int i = 0; i < 12; i++) {
 				slot[i].SetTables(tables);
+				slot[i].SetLane(&lanes, GetLane(i));
 			}
 
+#ifdef OPLL_AVX2
+			simdEnabled = __builtin_cpu_supports("avx2");
+#endif
+
 			mask = 0;
 			Reset(tables->clk, tables->rate);
 		}
@@ -398,6 +424,9 @@ namespace Vrc7Opll
 
 			carp->SL = (src[7] >> 4) & 0xF;
 			carp->RR = (src[7] & 0xF);
+
+			GetModulator(i)->UpdatePatch();
+			GetCarrier(i)->UpdatePatch();
 		}
 
 		/* Misc */
@@ -412,6 +441,17 @@ namespace Vrc7Opll
 			}
 		}
 
+		/* Selects between the AVX2 and scalar versions of calc (both produce the same output) */
+		bool SetSimdEnabled(bool enabled)
+		{
+#ifdef OPLL_AVX2
+			simdEnabled = enabled && __builtin_cpu_supports("avx2");
+#else
+			simdEnabled = false;
+#endif
+			return simdEnabled;
+		}
+
 		/* Channel Mask */
 		uint32_t SetMask(uint32_t mask)
 		{
@@ -492,26 +532,183 @@ namespace Vrc7Opll
 			lfo_pm = tables->pmtable[GetHighBits(pm_phase, PM_DP_BITS - PM_PG_BITS)];
 		}
 
+		/* Modulator and carrier output for each channel (calc_slot_mod/calc_slot_car) */
+		int32_t calc_output()
+		{
+			int32_t inst = 0;
+			const int16_t* db2lin = tables->DB2LIN_TABLE;
+			for(int i = 0; i < 6; i++) {
+				if(!(mask & OPLL_MASK_CH(i)) && lanes.eg_mode[i + 8] != FINISH) {
+					int32_t mod = lanes.output0[i];
+					int32_t output = 0;
+					if(lanes.egout[i] < DB_MUTE - 1) {
+						int32_t fm = ((lanes.feedback[i] >> (SLOT_AMP_BITS - PG_BITS - 1)) >> lanes.fb_shift[i]) & lanes.fb_mask[i];
+						output = db2lin[lanes.sintbl[i][(lanes.pgout[i] + fm) & (PG_WIDTH - 1)] + lanes.egout[i]];
+					}
+					lanes.output1[i] = mod;
+					lanes.output0[i] = output;
+					int32_t feedback = lanes.feedback[i] = (mod + output) >> 1;
+
+					int32_t car = lanes.output0[i + 8];
+					output = 0;
+					if(lanes.egout[i + 8] < DB_MUTE - 1) {
+						output = db2lin[lanes.sintbl[i + 8][(lanes.pgout[i + 8] + (feedback >> (SLOT_AMP_BITS - PG_BITS - 2))) & (PG_WIDTH - 1)] + lanes.egout[i + 8]];
+					}
+					lanes.output1[i + 8] = car;
+					lanes.output0[i + 8] = output;
+					inst += (car + output) >> 1;
+				}
+			}
+			return inst;
+		}
+
+#ifdef OPLL_AVX2
+		__attribute__((target("avx2")))
+		static __m256i load(void* src)
+		{
+			return _mm256_loadu_si256((__m256i*)src);
+		}
+
+		__attribute__((target("avx2")))
+		static void store(void* dst, __m256i value)
+		{
+			_mm256_storeu_si256((__m256i*)dst, value);
+		}
+
+		__attribute__((target("avx2")))
+		static __m256i modeIs(__m256i mode, int32_t value)
+		{
+			return _mm256_cmpeq_epi32(mode, _mm256_set1_epi32(value));
+		}
+
+		/* Sine and dB to linear lookups for 8 slots (output is 0 for slots whose envelope is at the attenuation limit) */
+		__attribute__((target("avx2")))
+		__m256i calc_slot_output_avx2(int lane, __m256i phaseOffset)
+		{
+			__m256i egout = load(lanes.egout + lane);
+			__m256i index = _mm256_and_si256(_mm256_add_epi32(load(lanes.pgout + lane), phaseOffset), _mm256_set1_epi32(PG_WIDTH - 1));
+			index = _mm256_add_epi32(index, load(lanes.wf_offset + lane));
+			__m256i db = _mm256_add_epi32(_mm256_i32gather_epi32((const int*)tables->SINTABLE32, index, 4), egout);
+			__m256i audible = _mm256_cmpgt_epi32(_mm256_set1_epi32(DB_MUTE - 1), egout);
+			return _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), tables->DB2LIN_TABLE32, db, audible, 4);
+		}
+
+		/* Same as calc_output, with the 6 modulators (and their feedback) processed in one vector, and then the 6 carriers */
+		__attribute__((target("avx2")))
+		int32_t calc_output_avx2()
+		{
+			/* Channels that are masked, or whose carrier is done, are left untouched */
+			__m256i channelBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+			__m256i unmasked = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(mask), channelBits), _mm256_setzero_si256());
+			__m256i active = _mm256_andnot_si256(modeIs(load(lanes.eg_mode + 8), FINISH), unmasked);
+
+			__m256i mod = load(lanes.output0);
+			__m256i fm = _mm256_srav_epi32(_mm256_srai_epi32(load(lanes.feedback), SLOT_AMP_BITS - PG_BITS - 1), load(lanes.fb_shift));
+			__m256i modOutput = calc_slot_output_avx2(0, _mm256_and_si256(fm, load(lanes.fb_mask)));
+			__m256i feedback = _mm256_srai_epi32(_mm256_add_epi32(mod, modOutput), 1);
+			store(lanes.output1, _mm256_blendv_epi8(load(lanes.output1), mod, active));
+			store(lanes.output0, _mm256_blendv_epi8(mod, modOutput, active));
+			store(lanes.feedback, _mm256_blendv_epi8(load(lanes.feedback), feedback, active));
+
+			__m256i car = load(lanes.output0 + 8);
+			__m256i carOutput = calc_slot_output_avx2(8, _mm256_srai_epi32(feedback, SLOT_AMP_BITS - PG_BITS - 2));
+			store(lanes.output1 + 8, _mm256_blendv_epi8(load(lanes.output1 + 8), car, active));
+			store(lanes.output0 + 8, _mm256_blendv_epi8(car, carOutput, active));
+
+			__m256i inst = _mm256_and_si256(_mm256_srai_epi32(_mm256_add_epi32(car, carOutput), 1), active);
+			__m128i sum = _mm_add_epi32(_mm256_castsi256_si128(inst), _mm256_extracti128_si256(inst, 1));
+			sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+			sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+			return _mm_cvtsi128_si32(sum);
+		}
+
+		/* Same as calc, with all 12 slots processed in 2 vectors of 8 lanes */
+		__attribute__((target("avx2")))
+		int32_t calc_avx2()
+		{
+			update_ampm();
+
+			const __m256i lfoPm = _mm256_set1_epi32(lfo_pm);
+			const __m256i lfoAm = _mm256_set1_epi32(lfo_am);
+			uint32_t scalarLanes = 0;
+
+			for(int i = 0; i < OpllLanes::Count; i += 8) {
+				/* Phase generator */
+				__m256i dphase = load(lanes.dphase + i);
+				__m256i pmDphase = _mm256_srli_epi32(_mm256_mullo_epi32(dphase, lfoPm), PM_AMP_BITS);
+				dphase = _mm256_blendv_epi8(dphase, pmDphase, load(lanes.pm_mask + i));
+				__m256i phase = _mm256_and_si256(_mm256_add_epi32(load(lanes.phase + i), dphase), _mm256_set1_epi32(DP_WIDTH - 1));
+				store(lanes.phase + i, phase);
+				store(lanes.pgout + i, _mm256_srli_epi32(phase, DP_BASE_BITS));
+
+				/* Envelope generator */
+				__m256i mode = load(lanes.eg_mode + i);
+				__m256i egPhase = load(lanes.eg_phase + i);
+				__m256i level = _mm256_srli_epi32(egPhase, EG_DP_BITS - EG_BITS);
+				__m256i attack = modeIs(mode, ATTACK);
+				__m256i decay = modeIs(mode, DECAY);
+				__m256i sustain = _mm256_or_si256(modeIs(mode, SUSTINE), modeIs(mode, RELEASE));
+				__m256i hold = modeIs(mode, SUSHOLD);
+
+				__m256i moving = _mm256_or_si256(_mm256_or_si256(attack, decay), sustain);
+				__m256i newEgPhase = _mm256_add_epi32(egPhase, _mm256_and_si256(load(lanes.eg_dphase + i), moving));
+
+				__m256i egout = _mm256_set1_epi32((1 << EG_BITS) - 1);
+				egout = _mm256_blendv_epi8(egout, level, _mm256_or_si256(_mm256_or_si256(decay, sustain), hold));
+				if(!_mm256_testz_si256(attack, attack)) {
+					egout = _mm256_mask_i32gather_epi32(egout, (const int*)tables->AR_ADJUST_TABLE32, level, attack, 4);
+				}
+
+				/* Sustain/release lanes that reached the end of the envelope */
+				__m256i finished = _mm256_and_si256(sustain, _mm256_cmpgt_epi32(level, _mm256_set1_epi32((1 << EG_BITS) - 1)));
+				mode = _mm256_blendv_epi8(mode, _mm256_set1_epi32(FINISH), finished);
+				egout = _mm256_blendv_epi8(egout, _mm256_set1_epi32((1 << EG_BITS) - 1), finished);
+
+				/* Lanes that change state need to update their envelope's speed - these are processed by the scalar code instead */
+				__m256i egWidth = _mm256_set1_epi32(EG_DP_WIDTH);
+				__m256i attackDone = _mm256_or_si256(_mm256_cmpeq_epi32(_mm256_and_si256(newEgPhase, egWidth), egWidth), load(lanes.ar_max_mask + i));
+				__m256i changing = _mm256_and_si256(attack, attackDone);
+				__m256i decayDone = _mm256_cmpeq_epi32(_mm256_max_epu32(newEgPhase, load(lanes.sl + i)), newEgPhase);
+				changing = _mm256_or_si256(changing, _mm256_and_si256(decay, decayDone));
+				changing = _mm256_or_si256(changing, _mm256_andnot_si256(load(lanes.eg_mask + i), hold));
+
+				/* Total level, AM and attenuation limit */
+				egout = _mm256_slli_epi32(_mm256_add_epi32(egout, load(lanes.tll + i)), 1);
+				egout = _mm256_add_epi32(egout, _mm256_and_si256(lfoAm, load(lanes.am_mask + i)));
+				egout = _mm256_min_epu32(egout, _mm256_set1_epi32(DB_MUTE - 1));
+
+				store(lanes.eg_mode + i, _mm256_blendv_epi8(mode, load(lanes.eg_mode + i), changing));
+				store(lanes.eg_phase + i, _mm256_blendv_epi8(newEgPhase, egPhase, changing));
+				store(lanes.egout + i, egout);
+				scalarLanes |= (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(changing)) << i;
+			}
+
+			while(scalarLanes) {
+				int lane = __builtin_ctz(scalarLanes);
+				scalarLanes &= scalarLanes - 1;
+				slot[lane < 8 ? lane * 2 : (lane - 8) * 2 + 1].calc_envelope(lfo_am);
+			}
+
+			return calc_output_avx2();
+		}
+#endif
+
 		int32_t calc()
 		{
-			int32_t inst = 0, out = 0;
-			int32_t i;
+#ifdef OPLL_AVX2
+			if(simdEnabled) {
+				return calc_avx2();
+			}
+#endif
 
 			update_ampm();
 
-			for(i = 0; i < 12; i++) {
+			for(int i = 0; i < 12; i++) {
 				slot[i].calc_phase(lfo_pm);
 				slot[i].calc_envelope(lfo_am);
 			}
 
-			for(i = 0; i < 6; i++) {
-				if(!(mask & OPLL_MASK_CH(i)) && (GetCarrier(i)->GetEgMode() != FINISH)) {
-					inst += GetCarrier(i)->calc_slot_car(GetModulator(i)->calc_slot_mod());
-				}
-			}
-
-			out = inst;
-			return (int32_t)out;
+			return calc_output();
 		}
 
 		int16_t GetOutput()
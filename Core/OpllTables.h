@@ -184,6 +184,11 @@ namespace Vrc7Opll {
 
 		uint16_t *waveform[2] = { fullsintable, halfsintable };
 
+		/* 32-bit copies of the tables read by OpllEmulator::calc_avx2 (AVX2 gathers load 4 bytes per entry) */
+		uint32_t SINTABLE32[PG_WIDTH * 2];   /* fullsintable followed by halfsintable */
+		int32_t DB2LIN_TABLE32[(DB_MUTE + DB_MUTE) * 2];
+		uint32_t AR_ADJUST_TABLE32[1 << EG_BITS];
+
 		/* Phase delta for LFO */
 		uint32_t pm_dphase;
 		uint32_t am_dphase;
@@ -244,6 +249,20 @@ namespace Vrc7Opll {
 				halfsintable[i] = fullsintable[0];
 		}
 
+		void makeGatherTables(void)
+		{
+			for(int32_t i = 0; i < PG_WIDTH; i++) {
+				SINTABLE32[i] = fullsintable[i];
+				SINTABLE32[PG_WIDTH + i] = halfsintable[i];
+			}
+			for(int32_t i = 0; i < (DB_MUTE + DB_MUTE) * 2; i++) {
+				DB2LIN_TABLE32[i] = DB2LIN_TABLE[i];
+			}
+			for(int32_t i = 0; i < (1 << EG_BITS); i++) {
+				AR_ADJUST_TABLE32[i] = AR_ADJUST_TABLE[i];
+			}
+		}
+
 		/* Table for Pitch Modulator */
 		void makePmTable(void)
 		{
@@ -390,6 +409,7 @@ namespace Vrc7Opll {
 			makeTllTable();
 			makeRksTable();
 			makeSinTable();
+			makeGatherTables();
 			//makeDefaultPatch ();
 
 			rate = r;
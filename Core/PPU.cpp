@@ -9,6 +9,7 @@
 #include "ControlManager.h"
 #include "MemoryManager.h"
 #include "Console.h"
+#include "Profiler.h"
 
 PPU::PPU(std::shared_ptr<Console> console)
 {
@@ -21,6 +22,7 @@ PPU::PPU(std::shared_ptr<Console> console)
 	_outputBuffers[1] = new uint16_t[256 * 240];
 
 	_currentOutputBuffer = _outputBuffers[0];
+	_renderSkip = false;
 	memset(_outputBuffers[0], 0, 256 * 240 * sizeof(uint16_t));
 	memset(_outputBuffers[1], 0, 256 * 240 * sizeof(uint16_t));
 
@@ -157,6 +159,11 @@ double PPU::GetOverclockRate()
 	return (double)(_vblankEnd + 2) / (regularVblankEnd + 2);
 }
 
+void PPU::SetRenderSkip(bool skip)
+{
+	_renderSkip = skip;
+}
+
 void PPU::GetState(PPUDebugState &state)
 {
 	state.ControlFlags = _flags;
@@ -858,6 +865,42 @@ void PPU::DrawPixel()
 	}
 }
 
+void PPU::UpdateSprite0Hit()
+{
+	//Used instead of DrawPixel when the frame will not be displayed - only the sprite 0 hit logic from GetPixelColor is needed
+	//(sprite 0 is always the first sprite, so no other sprite can hide it)
+	if(!_sprite0Visible || _spriteCount == 0 || _statusFlags.Sprite0Hit || !_flags.BackgroundEnabled || _cycle == 256 || !_hasSprite[_cycle]) {
+		return;
+	}
+
+	if(!IsRenderingEnabled() && (_state.VideoRamAddr & 0x3F00) == 0x3F00) {
+		//DrawPixel doesn't call GetPixelColor in this case
+		return;
+	}
+
+	if(_cycle <= _minimumDrawBgCycle || _cycle <= _minimumDrawSpriteCycle || _cycle <= _minimumDrawSpriteStandardCycle) {
+		return;
+	}
+
+	int32_t shift = (int32_t)_cycle - _spriteTiles[0].SpriteX - 1;
+	if(shift < 0 || shift >= 8) {
+		return;
+	}
+
+	uint8_t offset = _state.XScroll;
+	uint8_t spriteBgColor = (((_state.LowBitShift << offset) & 0x8000) >> 15) | (((_state.HighBitShift << offset) & 0x8000) >> 14);
+	uint8_t spriteColor;
+	if(_spriteTiles[0].HorizontalMirror) {
+		spriteColor = ((_spriteTiles[0].LowByte >> shift) & 0x01) | ((_spriteTiles[0].HighByte >> shift) & 0x01) << 1;
+	} else {
+		spriteColor = ((_spriteTiles[0].LowByte << shift) & 0x80) >> 7 | ((_spriteTiles[0].HighByte << shift) & 0x80) >> 6;
+	}
+
+	if(spriteColor != 0 && spriteBgColor != 0) {
+		_statusFlags.Sprite0Hit = true;
+	}
+}
+
 uint16_t PPU::GetCurrentBgColor()
 {
 	uint16_t color;
@@ -886,8 +929,8 @@ void PPU::UpdateGrayscaleAndIntensifyBits()
 		pixelNumber = (_scanline << 8) + 255;
 	}
 
-	if(_paletteRamMask == 0x3F && _intensifyColorBits == 0) {
-		//Nothing to do (most common case)
+	if((_paletteRamMask == 0x3F && _intensifyColorBits == 0) || _renderSkip) {
+		//Nothing to do (most common case, or the frame's pixels are not being output)
 		_lastUpdatedPixel = pixelNumber;
 		return;
 	}
@@ -916,7 +959,11 @@ void PPU::ProcessScanline()
 		}
 
 		if(_scanline >= 0) {
-			DrawPixel();
+			if(_renderSkip) {
+				UpdateSprite0Hit();
+			} else {
+				DrawPixel();
+			}
 			ShiftTileRegisters();
 
 			//"Secondary OAM clear and sprite evaluation do not occur on the pre-render line"
@@ -1225,8 +1272,26 @@ void PPU::ProcessOamCorruption()
 	}
 }
 
+uint64_t PPU::GetNextEventClock()
+{
+	//Returns the master clock at which the CPU must run the PPU again, at the latest, to see the end of the frame and the NMI on the same cycle as it would when running in lockstep
+	//Every other PPU side effect the CPU can observe goes through a register access, which forces a sync
+	int32_t cyclesLeft;
+	if(_scanline < 240) {
+		cyclesLeft = (240 - _scanline) * 341 - _cycle;
+	} else if(_scanline < _nmiScanline || (_scanline == _nmiScanline && _cycle < 1)) {
+		cyclesLeft = (_nmiScanline - _scanline) * 341 + 1 - _cycle;
+	} else {
+		cyclesLeft = (_vblankEnd - _scanline) * 341 + 341 - _cycle + 241 * 341;
+	}
+
+	//Stop 1 cycle early, in case the odd frame's skipped cycle is part of the interval
+	return _masterClock + std::max(cyclesLeft - 1, 0) * _masterClockDivider;
+}
+
 void PPU::Exec()
 {
+	PROFILE_SECTION(ProfilerSection::Ppu);
 	if(_cycle > 339) {
 		_cycle = 0;
 		if(++_scanline > _vblankEnd) {
@@ -107,6 +107,9 @@ class PPU : public IMemoryHandler, public Snapshotable
 		bool _enableOamDecay;
 		bool _corruptOamRow[32];
 
+		//When set, the frame's pixels are not output (only sprite 0 hits are evaluated)
+		bool _renderSkip;
+
 		void UpdateStatusFlag();
 
 		void SetControlRegister(uint8_t value);
@@ -149,6 +152,7 @@ class PPU : public IMemoryHandler, public Snapshotable
 
 		uint8_t GetPixelColor();
 		__forceinline virtual void DrawPixel();
+		void UpdateSprite0Hit();
 		void UpdateGrayscaleAndIntensifyBits();
 		virtual void SendFrame();
 
@@ -203,9 +207,12 @@ class PPU : public IMemoryHandler, public Snapshotable
 
 		void SetNesModel(NesModel model);
 		double GetOverclockRate();
+
+		void SetRenderSkip(bool skip);
 		
 		void Exec();
 		__forceinline void Run(uint64_t runTo);
+		uint64_t GetNextEventClock();
 
 		uint32_t GetFrameCount()
 		{
@@ -0,0 +1,91 @@
+#pragma once
+#include "stdafx.h"
+
+enum class ProfilerSection
+{
+	Cpu = 0,
+	Ppu = 1,
+	Apu = 2,
+	VideoFilter = 3,
+	Audio = 4,
+	Count = 5
+};
+
+#ifdef MESEN_PROFILER
+#include <chrono>
+
+//Opt-in per-subsystem timing, used by the benchmark tool (build with "make bench PROFILER=1")
+//Sections can be nested (e.g PPU::Exec runs inside CPU::Exec) - each section only records its exclusive time
+class Profiler
+{
+private:
+	struct Counters
+	{
+		uint64_t Time[(int)ProfilerSection::Count];
+		uint64_t Calls[(int)ProfilerSection::Count];
+	};
+
+	static Counters& GetCounters()
+	{
+		static Counters counters = {};
+		return counters;
+	}
+
+public:
+	class Scope
+	{
+	private:
+		ProfilerSection _section;
+		Scope* _parent;
+		uint64_t _childTime = 0;
+		std::chrono::high_resolution_clock::time_point _start;
+
+		static Scope*& GetCurrent()
+		{
+			//Per thread, the video filter can run on its own thread
+			static thread_local Scope* current = nullptr;
+			return current;
+		}
+
+	public:
+		Scope(ProfilerSection section)
+		{
+			_section = section;
+			_parent = GetCurrent();
+			GetCurrent() = this;
+			_start = std::chrono::high_resolution_clock::now();
+		}
+
+		~Scope()
+		{
+			uint64_t elapsed = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - _start).count();
+			Counters &counters = GetCounters();
+			counters.Time[(int)_section] += elapsed - _childTime;
+			counters.Calls[(int)_section]++;
+			if(_parent) {
+				_parent->_childTime += elapsed;
+			}
+			GetCurrent() = _parent;
+		}
+	};
+
+	static void Reset()
+	{
+		GetCounters() = {};
+	}
+
+	static uint64_t GetTime(ProfilerSection section)
+	{
+		return GetCounters().Time[(int)section];
+	}
+
+	static uint64_t GetCallCount(ProfilerSection section)
+	{
+		return GetCounters().Calls[(int)section];
+	}
+};
+
+#define PROFILE_SECTION(section) Profiler::Scope _profilerScope(section)
+#else
+#define PROFILE_SECTION(section)
+#endif
@@ -28,6 +28,8 @@ protected:
 		Stream(_irqCounter);
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		_irqCounter--;
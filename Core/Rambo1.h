@@ -25,6 +25,7 @@ protected:
 protected:
 	virtual uint16_t GetPRGPageSize() override { return 0x2000; }
 	virtual uint16_t GetCHRPageSize() override { return 0x400; }
+	virtual bool RequiresPpuSync() override { return true; }
 
 	void InitMapper() override
 	{
@@ -41,6 +42,8 @@ protected:
 				a12Watcher, _cpuClockCounter, _currentRegister, registers, _forceClock);
 	}
 
+	virtual bool RequiresCpuClock() override { return true; }
+
 	virtual void ProcessCpuClock() override
 	{
 		if(_needIrqDelay) {
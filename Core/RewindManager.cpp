@@ -0,0 +1,327 @@
+#include "stdafx.h"
+#include "RewindManager.h"
+#include "Console.h"
+#include "SaveStateManager.h"
+#include "BaseMapper.h"
+
+RewindManager::RewindManager(std::shared_ptr<Console> console, uint32_t maxMemoryUsage)
+{
+	_console = console;
+	_maxMemoryUsage = maxMemoryUsage;
+}
+
+void RewindManager::SetMaxMemoryUsage(uint32_t maxMemoryUsage)
+{
+	_maxMemoryUsage = maxMemoryUsage;
+	DiscardEntries();
+}
+
+void RewindManager::Reset()
+{
+	_history.clear();
+	_freeEntries.clear();
+	_memoryUsage = 0;
+	_currentStateSize = 0;
+}
+
+bool RewindManager::SaveState(vector<uint8_t> &buffer, uint32_t &stateSize, uint64_t ramStamp)
+{
+	if(buffer.empty()) {
+		buffer.resize(0x10000);
+	}
+
+	while(true) {
+		uint8_t* position = buffer.data();
+		if(_console->SaveState(position, buffer.data() + buffer.size(), ramStamp)) {
+			stateSize = (uint32_t)(position - buffer.data());
+			return true;
+		} else if(buffer.size() >= 0x4000000) {
+			return false;
+		}
+		buffer.resize(buffer.size() * 2);
+	}
+}
+
+static void WriteLength(uint8_t* &output, uint32_t value)
+{
+	while(value >= 0x80) {
+		*(output++) = (uint8_t)(value | 0x80);
+		value >>= 7;
+	}
+	*(output++) = (uint8_t)value;
+}
+
+static uint32_t ReadLength(uint8_t* &input)
+{
+	uint32_t value = 0;
+	for(int shift = 0; ; shift += 7) {
+		uint8_t b = *(input++);
+		value |= (uint32_t)(b & 0x7F) << shift;
+		if(!(b & 0x80)) {
+			return value;
+		}
+	}
+}
+
+void RewindManager::EncodeDelta(uint8_t* previous, uint8_t* next, uint32_t size, uint8_t* &output)
+{
+	//Worst case: every other byte changed, each change needs a 2-byte header (the caller makes sure the output is large enough)
+	uint32_t i = 0;
+	while(i < size) {
+		//Skip over the bytes that are identical in both states, 8 at a time when possible
+		uint32_t start = i;
+		while(i + 8 <= size) {
+			uint64_t a, b;
+			memcpy(&a, previous + i, 8);
+			memcpy(&b, next + i, 8);
+			if(a != b) {
+				break;
+			}
+			i += 8;
+		}
+		while(i < size && previous[i] == next[i]) {
+			i++;
+		}
+		uint32_t unchangedLength = i - start;
+
+		//Changed bytes - short runs of identical bytes are kept in the literal run to avoid emitting lots of tiny runs
+		start = i;
+		while(i < size) {
+			if(previous[i] != next[i]) {
+				i++;
+			} else {
+				uint32_t end = i;
+				while(end < size && end < i + 4 && previous[end] == next[end]) {
+					end++;
+				}
+				if(end - i >= 4 || end == size) {
+					break;
+				}
+				i = end;
+			}
+		}
+		uint32_t changedLength = i - start;
+
+		WriteLength(output, unchangedLength);
+		WriteLength(output, changedLength);
+		for(uint32_t j = start; j < i; j++) {
+			*(output++) = previous[j] ^ next[j];
+		}
+	}
+}
+
+void RewindManager::ApplyDelta(uint8_t* &input, uint8_t* state, uint32_t size)
+{
+	uint32_t i = 0;
+	while(i < size) {
+		i += ReadLength(input);
+		uint32_t changedLength = ReadLength(input);
+		for(uint32_t j = 0; j < changedLength; j++) {
+			state[i++] ^= *(input++);
+		}
+	}
+}
+
+void RewindManager::SetEntryData(RewindEntry &entry, uint8_t* data, uint32_t size)
+{
+	if(entry.Data.capacity() > (size_t)size * 2) {
+		//Don't let a recycled buffer waste memory (the memory limit is based on the buffers' capacity)
+		vector<uint8_t>().swap(entry.Data);
+	}
+	entry.Data.assign(data, data + size);
+	entry.DataSize = size;
+}
+
+void RewindManager::CopyRam(BaseMapper* mapper)
+{
+	uint32_t pageCount = mapper->GetRamPageCount();
+	_ram.assign((size_t)pageCount << 8, 0);
+	for(uint32_t i = 0; i < pageCount; i++) {
+		uint32_t size;
+		uint8_t* page = mapper->GetRamPage(i, size);
+		memcpy(_ram.data() + ((size_t)i << 8), page, size);
+	}
+}
+
+void RewindManager::RestoreModifiedPages(BaseMapper* mapper)
+{
+	//Undo the RAM writes done since the current state was recorded (e.g by the frame that is run after each step back)
+	uint32_t pageCount = mapper->GetRamPageCount();
+	for(uint32_t i = 0; i < pageCount; i++) {
+		if(mapper->IsRamPageModified(i, _ramStamp)) {
+			uint32_t size;
+			uint8_t* page = mapper->GetRamPage(i, size);
+			uint8_t* copy = _ram.data() + ((size_t)i << 8);
+			if(memcmp(page, copy, size) != 0) {
+				memcpy(page, copy, size);
+				mapper->MarkRamPageModified(i);
+			}
+		}
+	}
+}
+
+void RewindManager::DiscardOldestEntry()
+{
+	RewindEntry &entry = _history.front();
+	_memoryUsage -= entry.Data.capacity();
+	if(_freeEntries.empty()) {
+		//Keep one buffer around to be reused by the next state, to avoid an allocation every frame once the history is full
+		_freeEntries.push_back(std::move(entry));
+	}
+	_history.pop_front();
+}
+
+void RewindManager::DiscardEntries()
+{
+	while(GetMemoryUsage() > _maxMemoryUsage && !_history.empty()) {
+		DiscardOldestEntry();
+	}
+}
+
+void RewindManager::RecordState()
+{
+	if(_maxMemoryUsage == 0) {
+		return;
+	}
+
+	BaseMapper* mapper = _console->GetMapper();
+	uint64_t ramStamp = mapper->GetRamStamp();
+	if(_currentStateSize > 0 && (ramStamp >> 32) != (_ramStamp >> 32)) {
+		//The mapper was replaced (e.g power cycle), the copy of its RAM can't be used anymore
+		Reset();
+	}
+
+	//Every RAM page is older than the current stamp, the state only references them
+	uint32_t stateSize = 0;
+	if(!SaveState(_newState, stateSize, ramStamp)) {
+		return;
+	}
+
+	if(_currentStateSize == 0) {
+		CopyRam(mapper);
+	} else {
+		//Only the pages written to since the previous state can be different from the copy
+		_modifiedPages.clear();
+		uint32_t pageCount = mapper->GetRamPageCount();
+		for(uint32_t i = 0; i < pageCount; i++) {
+			if(mapper->IsRamPageModified(i, _ramStamp)) {
+				_modifiedPages.push_back(i);
+			}
+		}
+
+		size_t maxStateSize = std::max(stateSize, _currentStateSize);
+		size_t maxSize = maxStateSize + maxStateSize / 2 + 16 + _modifiedPages.size() * (0x100 + 0x80 + 16);
+		if(_deltaBuffer.size() < maxSize) {
+			_deltaBuffer.resize(maxSize);
+		}
+
+		RewindEntry entry;
+		if(!_freeEntries.empty()) {
+			entry = std::move(_freeEntries.back());
+			_freeEntries.pop_back();
+		}
+
+		uint8_t* output = _deltaBuffer.data();
+		if(_currentStateSize == stateSize) {
+			EncodeDelta(_currentState.data(), _newState.data(), stateSize, output);
+			entry.IsKeyFrame = false;
+		} else {
+			//State size changed (e.g a HD pack with audio was loaded), the delta can't be used - keep a full copy instead
+			memcpy(output, _currentState.data(), _currentStateSize);
+			output += _currentStateSize;
+			entry.IsKeyFrame = true;
+		}
+		entry.StateDataSize = (uint32_t)(output - _deltaBuffer.data());
+
+		for(uint32_t index : _modifiedPages) {
+			uint32_t size;
+			uint8_t* page = mapper->GetRamPage(index, size);
+			uint8_t* copy = _ram.data() + ((size_t)index << 8);
+			if(memcmp(copy, page, size) != 0) {
+				WriteLength(output, index);
+				EncodeDelta(copy, page, size, output);
+				memcpy(copy, page, size);
+			}
+		}
+
+		SetEntryData(entry, _deltaBuffer.data(), (uint32_t)(output - _deltaBuffer.data()));
+		entry.StateSize = _currentStateSize;
+		_memoryUsage += entry.Data.capacity();
+		_history.push_back(std::move(entry));
+	}
+
+	std::swap(_currentState, _newState);
+	_currentStateSize = stateSize;
+	_ramStamp = ramStamp;
+	DiscardEntries();
+}
+
+bool RewindManager::StepBack()
+{
+	if(_currentStateSize == 0) {
+		return false;
+	}
+
+	BaseMapper* mapper = _console->GetMapper();
+	if((mapper->GetRamStamp() >> 32) != (_ramStamp >> 32)) {
+		Reset();
+		return false;
+	}
+
+	RestoreModifiedPages(mapper);
+
+	//Once the history is exhausted, stay on the oldest state
+	bool result = false;
+	if(!_history.empty()) {
+		RewindEntry &entry = _history.back();
+		uint8_t* input = entry.Data.data();
+		if(entry.IsKeyFrame) {
+			if(_currentState.size() < entry.StateSize) {
+				_currentState.resize(entry.StateSize);
+			}
+			memcpy(_currentState.data(), input, entry.StateSize);
+			input += entry.StateDataSize;
+		} else {
+			ApplyDelta(input, _currentState.data(), entry.StateSize);
+		}
+		_currentStateSize = entry.StateSize;
+
+		uint8_t* end = entry.Data.data() + entry.DataSize;
+		while(input < end) {
+			uint32_t index = ReadLength(input);
+			uint32_t size;
+			uint8_t* page = mapper->GetRamPage(index, size);
+			uint8_t* copy = _ram.data() + ((size_t)index << 8);
+			ApplyDelta(input, copy, size);
+			memcpy(page, copy, size);
+			mapper->MarkRamPageModified(index);
+		}
+
+		_memoryUsage -= entry.Data.capacity();
+		if(_freeEntries.empty()) {
+			_freeEntries.push_back(std::move(entry));
+		}
+		_history.pop_back();
+		result = true;
+	}
+
+	//The state only references the RAM pages, which already match it
+	_ramStamp = mapper->GetRamStamp();
+	uint8_t* position = _currentState.data();
+	_console->LoadState(position, position + _currentStateSize, SaveStateManager::FileFormatVersion);
+	return result;
+}
+
+uint32_t RewindManager::GetHistoryLength()
+{
+	return (uint32_t)_history.size();
+}
+
+size_t RewindManager::GetMemoryUsage()
+{
+	size_t usage = _memoryUsage + _currentState.capacity() + _newState.capacity() + _deltaBuffer.capacity() + _ram.capacity() + _modifiedPages.capacity() * sizeof(uint32_t);
+	for(RewindEntry &entry : _freeEntries) {
+		usage += entry.Data.capacity();
+	}
+	return usage;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "stdafx.h"
+#include <memory>
+#include <deque>
+
+class Console;
+class BaseMapper;
+
+//Keeps the last few seconds of emulation in memory to allow stepping back one frame at a time
+//The mapper's RAM (work/save/CHR/nametable RAM) is not part of the recorded states: a copy of it is kept up to date using the
+//mapper's page stamps, so only the pages written to during the frame are compared - the states only contain everything else.
+//The newest state is kept as-is, older states are stored as XOR deltas against the state that follows them (along with the
+//XOR deltas of the RAM pages that changed), run-length encoded so that the parts that didn't change cost almost nothing
+class RewindManager
+{
+private:
+	std::shared_ptr<Console> _console;
+
+	//Delta to go from the next state back to this one (or a full copy of the state when IsKeyFrame is set), followed by the RAM page deltas
+	struct RewindEntry
+	{
+		vector<uint8_t> Data;
+		uint32_t DataSize = 0;
+		uint32_t StateDataSize = 0;
+		uint32_t StateSize = 0;
+		bool IsKeyFrame = false;
+	};
+
+	std::deque<RewindEntry> _history;
+	vector<RewindEntry> _freeEntries;
+
+	vector<uint8_t> _currentState;
+	uint32_t _currentStateSize = 0;
+	vector<uint8_t> _newState;
+	vector<uint8_t> _deltaBuffer;
+
+	//Copy of the mapper's RAM pages for the current state, and the stamp to use to find the pages written to since then
+	vector<uint8_t> _ram;
+	vector<uint32_t> _modifiedPages;
+	uint64_t _ramStamp = 0;
+
+	size_t _memoryUsage = 0;
+	size_t _maxMemoryUsage = 0;
+
+	bool SaveState(vector<uint8_t> &buffer, uint32_t &stateSize, uint64_t ramStamp);
+	void EncodeDelta(uint8_t* previous, uint8_t* next, uint32_t size, uint8_t* &output);
+	void ApplyDelta(uint8_t* &input, uint8_t* state, uint32_t size);
+	void SetEntryData(RewindEntry &entry, uint8_t* data, uint32_t size);
+	void CopyRam(BaseMapper* mapper);
+	void RestoreModifiedPages(BaseMapper* mapper);
+	void DiscardOldestEntry();
+	void DiscardEntries();
+
+public:
+	RewindManager(std::shared_ptr<Console> console, uint32_t maxMemoryUsage);
+
+	void SetMaxMemoryUsage(uint32_t maxMemoryUsage);
+	void Reset();
+
+	//Called once per frame, after the frame is done
+	void RecordState();
+
+	//Restores the state recorded before the current one - once the history is exhausted, the oldest state is restored again and false is returned
+	bool StepBack();
+
+	uint32_t GetHistoryLength();
+
+	//Includes the buffers used to record the states, and the copy of the mapper's RAM
+	size_t GetMemoryUsage();
+};
@@ -0,0 +1,147 @@
+#include "stdafx.h"
+#include "RunAheadManager.h"
+#include "Console.h"
+#include "SaveStateManager.h"
+#include "BaseMapper.h"
+#include "VideoDecoder.h"
+#include "VideoRenderer.h"
+#include "SoundMixer.h"
+#include "CheatManager.h"
+#include "BatteryManager.h"
+#include "VirtualFile.h"
+
+RunAheadManager::RunAheadManager(shared_ptr<Console> console, uint32_t frameCount)
+{
+	_console = console;
+	_frameCount = frameCount;
+}
+
+RunAheadManager::~RunAheadManager()
+{
+	UnloadGame();
+}
+
+void RunAheadManager::SetFrameCount(uint32_t frameCount)
+{
+	_frameCount = frameCount;
+}
+
+bool RunAheadManager::LoadGame(VirtualFile &romFile, retro_environment_t retroEnv, retro_video_refresh_t videoCallback)
+{
+	UnloadGame();
+
+	shared_ptr<Console> console(new Console());
+	console->ShareSettings(_console);
+	console->Init(retroEnv);
+
+	//Loading the game may apply a patch to the file, keep the caller's copy untouched
+	VirtualFile rom = romFile;
+	if(!console->Initialize(rom)) {
+		console->Release(true);
+		return false;
+	}
+
+	//The run-ahead console's state is always overwritten by the main console's - it must never write the battery files, or play sound
+	console->GetBatteryManager()->SetSaveEnabled(false);
+	console->GetSoundMixer()->SetSkipMode(true);
+	console->GetVideoRenderer()->SetVideoCallback(videoCallback);
+
+	_runAheadConsole = console;
+	_syncRamStamp = 0;
+	_runAheadRamStamp = 0;
+	SyncCheats();
+	return true;
+}
+
+void RunAheadManager::UnloadGame()
+{
+	if(_runAheadConsole) {
+		_runAheadConsole->Release(true);
+		_runAheadConsole.reset();
+	}
+}
+
+shared_ptr<Console> RunAheadManager::GetRunAheadConsole()
+{
+	return _runAheadConsole;
+}
+
+void RunAheadManager::SyncCheats()
+{
+	if(_runAheadConsole) {
+		_runAheadConsole->GetCheatManager()->CopyCodes(_console->GetCheatManager());
+	}
+}
+
+void RunAheadManager::UpdateHdPackMode()
+{
+	if(_runAheadConsole) {
+		_runAheadConsole->UpdateHdPackMode();
+	}
+}
+
+bool RunAheadManager::SyncState()
+{
+	if(_stateBuffer.empty()) {
+		_stateBuffer.resize(0x10000);
+	}
+
+	BaseMapper* mapper = _console->GetMapper();
+	BaseMapper* runAheadMapper = _runAheadConsole->GetMapper();
+
+	//The pages the run-ahead console wrote to since the last copy must be restored too
+	uint64_t baseRamStamp = _syncRamStamp;
+	if(baseRamStamp) {
+		mapper->MarkRamModified(runAheadMapper, _runAheadRamStamp);
+	}
+
+	uint8_t* position = _stateBuffer.data();
+	_syncRamStamp = mapper->GetRamStamp();
+	while(!_console->SaveState(position, _stateBuffer.data() + _stateBuffer.size(), baseRamStamp)) {
+		if(_stateBuffer.size() >= 0x4000000) {
+			_syncRamStamp = 0;
+			return false;
+		}
+		_stateBuffer.resize(_stateBuffer.size() * 2);
+		position = _stateBuffer.data();
+		_syncRamStamp = mapper->GetRamStamp();
+	}
+
+	uint8_t* end = position;
+	position = _stateBuffer.data();
+	_runAheadRamStamp = runAheadMapper->GetRamStamp();
+	_runAheadConsole->LoadState(position, end, SaveStateManager::FileFormatVersion);
+	return true;
+}
+
+void RunAheadManager::RunFrame()
+{
+	if(!_runAheadConsole || _frameCount == 0) {
+		_console->RunSingleFrame();
+		return;
+	}
+
+	//The main console's frame is never displayed, skip the video filters entirely
+	shared_ptr<VideoDecoder> decoder = _console->GetVideoDecoder();
+	shared_ptr<VideoRenderer> renderer = _console->GetVideoRenderer();
+	decoder->SetDecodingDisabled(true);
+	renderer->SetSkipMode(true);
+	_console->RunSingleFrame();
+	decoder->SetDecodingDisabled(false);
+	renderer->SetSkipMode(false);
+
+	if(!SyncState()) {
+		return;
+	}
+
+	decoder = _runAheadConsole->GetVideoDecoder();
+	renderer = _runAheadConsole->GetVideoRenderer();
+	for(uint32_t i = 0; i < _frameCount; i++) {
+		bool lastFrame = i == _frameCount - 1;
+		decoder->SetDecodingDisabled(!lastFrame);
+		renderer->SetSkipMode(!lastFrame);
+		_runAheadConsole->RunSingleFrame();
+	}
+	decoder->SetDecodingDisabled(false);
+	renderer->SetSkipMode(false);
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "stdafx.h"
+#include <memory>
+#include "../Libretro/libretro.h"
+
+class Console;
+class VirtualFile;
+
+//Reduces input latency by displaying frames that haven't been emulated yet:
+//the main console runs the actual frame (and produces the audio), then its state is copied to a second console
+//which runs a few frames ahead with the current input - only the last of these frames is displayed.
+//The state is copied through a memory buffer, nothing is written to disk.
+//Only the mapper RAM pages modified (by either console) since the previous copy are included in the state, the others are referenced.
+class RunAheadManager
+{
+private:
+	std::shared_ptr<Console> _console;
+	std::shared_ptr<Console> _runAheadConsole;
+	uint32_t _frameCount = 0;
+
+	vector<uint8_t> _stateBuffer;
+
+	//RAM stamps of the main console's last state, and of the run-ahead console before it loaded it (0 = the next copy includes all pages)
+	uint64_t _syncRamStamp = 0;
+	uint64_t _runAheadRamStamp = 0;
+
+	bool SyncState();
+
+public:
+	RunAheadManager(std::shared_ptr<Console> console, uint32_t frameCount);
+	~RunAheadManager();
+
+	void SetFrameCount(uint32_t frameCount);
+
+	//Loads the game in the run-ahead console, must be called once the main console has loaded it
+	bool LoadGame(VirtualFile &romFile, retro_environment_t retroEnv, retro_video_refresh_t videoCallback);
+	void UnloadGame();
+
+	std::shared_ptr<Console> GetRunAheadConsole();
+
+	void SyncCheats();
+	void UpdateHdPackMode();
+
+	//Replaces Console::RunSingleFrame
+	void RunFrame();
+};
@@ -39,6 +39,66 @@ void SaveStateManager::SaveState(ostream &stream)
 	_console->SaveState(stream);
 }
 
+void SaveStateManager::ClearStateHeaderCache()
+{
+	_stateHeader.clear();
+}
+
+vector<uint8_t>& SaveStateManager::GetCachedStateHeader()
+{
+	if(_stateHeader.empty()) {
+		stringstream stream;
+		GetSaveStateHeader(stream);
+		string header = stream.str();
+		_stateHeader.assign(header.begin(), header.end());
+	}
+	return _stateHeader;
+}
+
+bool SaveStateManager::SaveState(uint8_t* buffer, uint32_t bufferSize, uint32_t &stateSize)
+{
+	vector<uint8_t> &header = GetCachedStateHeader();
+	if(bufferSize < header.size()) {
+		return false;
+	}
+
+	memcpy(buffer, header.data(), header.size());
+	uint8_t* position = buffer + header.size();
+	if(!_console->SaveState(position, buffer + bufferSize)) {
+		return false;
+	}
+	stateSize = (uint32_t)(position - buffer);
+	return true;
+}
+
+uint32_t SaveStateManager::GetStateSize()
+{
+	if(_sizeBuffer.empty()) {
+		_sizeBuffer.resize(0x10000);
+	}
+
+	uint32_t stateSize = 0;
+	while(!SaveState(_sizeBuffer.data(), (uint32_t)_sizeBuffer.size(), stateSize)) {
+		_sizeBuffer.resize(_sizeBuffer.size() * 2);
+	}
+	return stateSize;
+}
+
+bool SaveStateManager::LoadState(uint8_t* buffer, uint32_t bufferSize, bool hashCheckRequired)
+{
+	vector<uint8_t> &header = GetCachedStateHeader();
+	if(bufferSize < header.size() || memcmp(buffer, header.data(), header.size()) != 0) {
+		//State was not saved by this version for the current game, use the stream-based logic (validation, loading the matching rom, etc.)
+		stringstream stream;
+		stream.write((char*)buffer, bufferSize);
+		return LoadState(stream, hashCheckRequired);
+	}
+
+	uint8_t* position = buffer + header.size();
+	_console->LoadState(position, buffer + bufferSize, SaveStateManager::FileFormatVersion);
+	return true;
+}
+
 bool SaveStateManager::LoadState(istream &stream, bool hashCheckRequired)
 {
 	char header[3];
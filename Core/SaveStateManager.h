@@ -8,13 +8,28 @@ class SaveStateManager
 {
 private:
 	std::shared_ptr<Console> _console;
+
+	//Header of the current game's save states, cached to avoid rebuilding it for every state saved to/loaded from memory (cleared when a game is loaded)
+	vector<uint8_t> _stateHeader;
+	vector<uint8_t> _sizeBuffer;
+
+	vector<uint8_t>& GetCachedStateHeader();
+
 public:
 	static constexpr uint32_t FileFormatVersion = 13;
 
 	SaveStateManager(std::shared_ptr<Console> console);
 
 	void GetSaveStateHeader(ostream & stream);
+	void ClearStateHeaderCache();
 
 	void SaveState(ostream &stream);
 	bool LoadState(istream &stream, bool hashCheckRequired = true);
+
+	//Same as above, without going through a stream (no memory allocations once the header is cached)
+	bool SaveState(uint8_t* buffer, uint32_t bufferSize, uint32_t &stateSize);
+	bool LoadState(uint8_t* buffer, uint32_t bufferSize, bool hashCheckRequired = true);
+
+	//Exact size of a save state of the current game (the size can change while the game runs, e.g when the FDS disk or the mapper's state changes)
+	uint32_t GetStateSize();
 };
@@ -31,20 +31,52 @@ uint32_t ScaleFilter::GetScale()
 	return _filterScale;
 }
 
-void ScaleFilter::ApplyPrescaleFilter(uint32_t *inputArgbBuffer)
+void ScaleFilter::ApplyPrescaleFilter(uint32_t *inputArgbBuffer, uint32_t startRow, uint32_t endRow, bool scanlines)
 {
-	uint32_t* outputBuffer = _outputBuffer;
+	uint32_t outputWidth = _width * _filterScale;
+	uint32_t* outputBuffer = _outputBuffer + startRow * outputWidth * _filterScale;
+	inputArgbBuffer += startRow * _width;
 
-	for(uint32_t y = 0; y < _height; y++) {
+	for(uint32_t y = startRow; y < endRow; y++) {
+		uint32_t* firstRow = outputBuffer;
 		for(uint32_t x = 0; x < _width; x++) {
+			uint32_t color = *(inputArgbBuffer++);
 			for(uint32_t i = 0; i < _filterScale; i++) {
-				*(outputBuffer++) = *inputArgbBuffer;
+				*(outputBuffer++) = color;
 			}
-			inputArgbBuffer++;
 		}
+
+		//All the rows generated by a source row are identical, so are their darkened versions
+		uint32_t* darkRow = nullptr;
 		for(uint32_t i = 1; i < _filterScale; i++) {
-			memcpy(outputBuffer, outputBuffer - _width*_filterScale, _width*_filterScale *4);
-			outputBuffer += _width*_filterScale;
+			bool isDarkRow = scanlines && ((y * _filterScale + i) & 0x01);
+			if(isDarkRow && !darkRow) {
+				darkRow = outputBuffer;
+				for(uint32_t x = 0; x < outputWidth; x++) {
+					uint32_t color = firstRow[x];
+					darkRow[x] = BaseVideoFilter::ApplyScanlineLut(_scanlineLut, color);
+				}
+			} else {
+				memcpy(outputBuffer, isDarkRow ? darkRow : firstRow, outputWidth * sizeof(uint32_t));
+			}
+			outputBuffer += outputWidth;
+		}
+
+		if(scanlines && (y * _filterScale & 0x01)) {
+			//Odd scale factors: every other source row starts on a darkened row
+			ApplyScanlines(y * _filterScale, y * _filterScale + 1);
+		}
+	}
+}
+
+void ScaleFilter::ApplyScanlines(uint32_t startRow, uint32_t endRow)
+{
+	uint32_t outputWidth = _width * _filterScale;
+	for(uint32_t y = startRow | 0x01; y < endRow; y += 2) {
+		uint32_t* row = _outputBuffer + y * outputWidth;
+		for(uint32_t x = 0; x < outputWidth; x++) {
+			uint32_t color = row[x];
+			row[x] = BaseVideoFilter::ApplyScanlineLut(_scanlineLut, color);
 		}
 	}
 }
@@ -62,40 +94,54 @@ void ScaleFilter::UpdateOutputBuffer(uint32_t width, uint32_t height)
 	}
 }
 
-uint32_t* ScaleFilter::ApplyFilter(uint32_t *inputArgbBuffer, uint32_t width, uint32_t height, double scanlineIntensity)
+uint32_t* ScaleFilter::ApplyFilter(uint32_t *inputArgbBuffer, uint32_t width, uint32_t height, double scanlineIntensity, uint32_t threadCount)
 {
 	UpdateOutputBuffer(width, height);
 
-	if(_scaleFilterType == ScaleFilterType::xBRZ) {
-		xbrz::scale(_filterScale, inputArgbBuffer, _outputBuffer, width, height, xbrz::ColorFormat::ARGB);
-	} else if(_scaleFilterType == ScaleFilterType::HQX) {
-		hqx(_filterScale, inputArgbBuffer, _outputBuffer, width, height);
-	} else if(_scaleFilterType == ScaleFilterType::Scale2x) {
-		scale(_filterScale, _outputBuffer, width*sizeof(uint32_t)*_filterScale, inputArgbBuffer, width*sizeof(uint32_t), 4, width, height);
-	} else if(_scaleFilterType == ScaleFilterType::_2xSai) {
-		twoxsai_generic_xrgb8888(width, height, inputArgbBuffer, width, _outputBuffer, width * _filterScale);
-	} else if(_scaleFilterType == ScaleFilterType::Super2xSai) {
-		supertwoxsai_generic_xrgb8888(width, height, inputArgbBuffer, width, _outputBuffer, width * _filterScale);
-	} else if(_scaleFilterType == ScaleFilterType::SuperEagle) {
-		supereagle_generic_xrgb8888(width, height, inputArgbBuffer, width, _outputBuffer, width * _filterScale);
-	} else if(_scaleFilterType == ScaleFilterType::Prescale) {
-		ApplyPrescaleFilter(inputArgbBuffer);
+	if(threadCount == 0) {
+		threadCount = ThreadPool::GetDefaultThreadCount();
+	}
+	if(!_threadPool || _threadPool->GetThreadCount() != threadCount) {
+		_threadPool.reset(new ThreadPool(threadCount));
 	}
 
 	scanlineIntensity = 1.0 - scanlineIntensity;
+	bool scanlines = scanlineIntensity < 1.0;
+	if(scanlines) {
+		BaseVideoFilter::InitScanlineLut(_scanlineLut, scanlineIntensity);
+	}
 
-	if(scanlineIntensity < 1.0) {
-		for(int y = 1, yMax = height * _filterScale; y < yMax; y += 2) {
-			for(int x = 0, xMax = width * _filterScale; x < xMax; x++) {
-				uint32_t &color = _outputBuffer[y*xMax + x];
-				uint8_t r = (color >> 16) & 0xFF, g = (color >> 8) & 0xFF, b = color & 0xFF;
-				r = (uint8_t)(r * scanlineIntensity);
-				g = (uint8_t)(g * scanlineIntensity);
-				b = (uint8_t)(b * scanlineIntensity);
-				color = 0xFF000000 | (r << 16) | (g << 8) | b;
-			}
+	//The SaI filters process the whole frame in one pass
+	bool canSlice = _scaleFilterType != ScaleFilterType::_2xSai && _scaleFilterType != ScaleFilterType::Super2xSai && _scaleFilterType != ScaleFilterType::SuperEagle;
+	uint32_t bandCount = canSlice ? std::min<uint32_t>(threadCount, height) : 1;
+
+	//Each band darkens its own scanlines right after scaling them, while they are still in the cache
+	_threadPool->Run(bandCount, [=](uint32_t band) {
+		uint32_t startRow = height * band / bandCount;
+		uint32_t endRow = height * (band + 1) / bandCount;
+
+		if(_scaleFilterType == ScaleFilterType::xBRZ) {
+			xbrz::scale(_filterScale, inputArgbBuffer, _outputBuffer, width, height, xbrz::ColorFormat::ARGB, xbrz::ScalerCfg(), startRow, endRow);
+		} else if(_scaleFilterType == ScaleFilterType::HQX) {
+			hqx_slice(_filterScale, inputArgbBuffer, _outputBuffer, width, height, startRow, endRow);
+		} else if(_scaleFilterType == ScaleFilterType::Scale2x) {
+			scale_slice(_filterScale, _outputBuffer, width*sizeof(uint32_t)*_filterScale, inputArgbBuffer, width*sizeof(uint32_t), 4, width, height, startRow, endRow);
+		} else if(_scaleFilterType == ScaleFilterType::_2xSai) {
+			twoxsai_generic_xrgb8888(width, height, inputArgbBuffer, width, _outputBuffer, width * _filterScale);
+		} else if(_scaleFilterType == ScaleFilterType::Super2xSai) {
+			supertwoxsai_generic_xrgb8888(width, height, inputArgbBuffer, width, _outputBuffer, width * _filterScale);
+		} else if(_scaleFilterType == ScaleFilterType::SuperEagle) {
+			supereagle_generic_xrgb8888(width, height, inputArgbBuffer, width, _outputBuffer, width * _filterScale);
+		} else if(_scaleFilterType == ScaleFilterType::Prescale) {
+			//Darkens its rows as it generates them
+			ApplyPrescaleFilter(inputArgbBuffer, startRow, endRow, scanlines);
+			return;
 		}
-	}
+
+		if(scanlines) {
+			ApplyScanlines(startRow * _filterScale, endRow * _filterScale);
+		}
+	});
 
 	return _outputBuffer;
 }
@@ -2,6 +2,7 @@
 
 #include "stdafx.h"
 #include "DefaultVideoFilter.h"
+#include "../Utilities/ThreadPool.h"
 
 class ScaleFilter
 {
@@ -13,7 +14,12 @@ private:
 	uint32_t _width = 0;
 	uint32_t _height = 0;
 
-	void ApplyPrescaleFilter(uint32_t *inputArgbBuffer);
+	//The scalers only look at the neighboring rows, the frame is split into bands that are scaled in parallel
+	std::unique_ptr<ThreadPool> _threadPool;
+	uint8_t _scanlineLut[256];
+
+	void ApplyPrescaleFilter(uint32_t *inputArgbBuffer, uint32_t startRow, uint32_t endRow, bool scanlines);
+	void ApplyScanlines(uint32_t startRow, uint32_t endRow);
 	void UpdateOutputBuffer(uint32_t width, uint32_t height);
 
 public:
@@ -21,7 +27,7 @@ public:
 	~ScaleFilter();
 
 	uint32_t GetScale();
-	uint32_t* ApplyFilter(uint32_t *inputArgbBuffer, uint32_t width, uint32_t height, double scanlineIntensity);
+	uint32_t* ApplyFilter(uint32_t *inputArgbBuffer, uint32_t width, uint32_t height, double scanlineIntensity, uint32_t threadCount);
 	FrameInfo GetFrameInfo(FrameInfo baseFrameInfo);
 
 	static shared_ptr<ScaleFilter> GetScaleFilter(VideoFilterType filter);
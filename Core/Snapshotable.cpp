@@ -10,14 +10,16 @@ void Snapshotable::StreamStartBlock()
 	}
 
 	if(!_saving) {
+		uint32_t count = 0;
 		InternalStream(_blockSize);
-		_blockSize = std::min(_blockSize, (uint32_t)0xFFFFF);
-		_blockBuffer = new uint8_t[_blockSize];
-		ArrayInfo<uint8_t> arrayInfo = { _blockBuffer, _blockSize };
-		InternalStream(arrayInfo);
+		StreamElement<uint32_t>(count);
+
+		//Read the block directly from the stream, no copy needed
+		_blockSize = std::min(_blockSize, count);
+		_blockBuffer = ReadBytes(_blockSize);
 	} else {
-		_blockSize = 0x100;
-		_blockBuffer = new uint8_t[_blockSize];
+		_blockBuffer = _blockData.data();
+		_blockSize = (uint32_t)_blockData.size();
 	}
 	_blockPosition = 0;
 	_inBlock = true;
@@ -32,80 +34,113 @@ void Snapshotable::StreamEndBlock()
 		InternalStream(arrayInfo);
 	}
 
-	delete[] _blockBuffer;
 	_blockBuffer = nullptr;
 }
 
 void Snapshotable::Stream(Snapshotable* snapshotable)
 {
-	stringstream stream;
 	if(_saving) {
-		snapshotable->SaveSnapshot(&stream);
-		uint32_t size = (uint32_t)stream.tellp();
-		stream.seekg(0, ios::beg);
-		stream.seekp(0, ios::beg);
-
-		uint8_t *buffer = new uint8_t[size];
-		stream.read((char*)buffer, size);
+		//Same layout as SaveSnapshot(ostream*): the snapshot's size, followed by its data
+		snapshotable->SaveToBuffer();
+		uint32_t size = snapshotable->_position + sizeof(uint32_t);
 		InternalStream(size);
-		ArrayInfo<uint8_t> arrayInfo = { buffer, size };
-		InternalStream(arrayInfo);
-		delete[] buffer;
+		StreamElement<uint32_t>(size);
+		StreamElement<uint32_t>(snapshotable->_position);
+		WriteBytes(snapshotable->_stream, snapshotable->_position);
 	} else {
 		uint32_t size = 0;
+		uint32_t count = 0;
 		InternalStream(size);
+		StreamElement<uint32_t>(count);
 
-		uint8_t *buffer = new uint8_t[size];
-		ArrayInfo<uint8_t> arrayInfo = { buffer, size };
-		InternalStream(arrayInfo);
+		size = std::min(size, count);
+		uint8_t* data = ReadBytes(size);
 
-		stream.write((char*)buffer, size);
-		stream.seekg(0, ios::beg);
-		stream.seekp(0, ios::beg);
-		snapshotable->LoadSnapshot(&stream, _stateVersion);
-		delete[] buffer;
+		uint32_t streamSize = 0;
+		if(size >= sizeof(uint32_t)) {
+			memcpy(&streamSize, data, sizeof(uint32_t));
+		}
+		snapshotable->LoadFromBuffer(data + sizeof(uint32_t), std::min(streamSize, size >= sizeof(uint32_t) ? size - (uint32_t)sizeof(uint32_t) : 0), _stateVersion);
 	}
 }
 
-void Snapshotable::SaveSnapshot(ostream* file)
+void Snapshotable::SaveToBuffer()
 {
 	_stateVersion = SaveStateManager::FileFormatVersion;
 
-	_streamSize = 0x1000;
-	_stream = new uint8_t[_streamSize];
+	_stream = _streamData.data();
+	_streamSize = (uint32_t)_streamData.size();
 	_position = 0;
 	_saving = true;
 
 	StreamState(_saving);
-	file->write((char*)&_position, sizeof(_position));
-	file->write((char*)_stream, _position);
-
-	delete[] _stream;
 
-	if(_blockBuffer) {
+	if(_inBlock) {
 		throw new std::runtime_error("A call to StreamEndBlock is missing.");
 	}
 }
 
-void Snapshotable::LoadSnapshot(istream* file, uint32_t stateVersion)
+void Snapshotable::LoadFromBuffer(uint8_t* data, uint32_t size, uint32_t stateVersion)
 {
 	_stateVersion = stateVersion;
 
+	_stream = data;
+	_streamSize = size;
 	_position = 0;
 	_saving = false;
 
-	file->read((char*)&_streamSize, sizeof(_streamSize));
-	_stream = new uint8_t[_streamSize];
-	file->read((char*)_stream, _streamSize);
 	StreamState(_saving);
 
-	delete[] _stream;
+	_stream = nullptr;
 
-	if(_blockBuffer) {
+	if(_inBlock) {
 		throw new std::runtime_error("A call to StreamEndBlock is missing.");
 	}
 }
 
+void Snapshotable::SaveSnapshot(ostream* file)
+{
+	SaveToBuffer();
+	file->write((char*)&_position, sizeof(_position));
+	file->write((char*)_stream, _position);
+}
+
+void Snapshotable::LoadSnapshot(istream* file, uint32_t stateVersion)
+{
+	uint32_t size = 0;
+	file->read((char*)&size, sizeof(size));
+	if(_streamData.size() < size) {
+		_streamData.resize(size);
+	}
+	file->read((char*)_streamData.data(), size);
+	LoadFromBuffer(_streamData.data(), size, stateVersion);
+}
+
+bool Snapshotable::SaveSnapshot(uint8_t* &buffer, uint8_t* bufferEnd)
+{
+	SaveToBuffer();
+	if((size_t)(bufferEnd - buffer) < _position + sizeof(_position)) {
+		return false;
+	}
+
+	memcpy(buffer, &_position, sizeof(_position));
+	memcpy(buffer + sizeof(_position), _stream, _position);
+	buffer += _position + sizeof(_position);
+	return true;
+}
+
+void Snapshotable::LoadSnapshot(uint8_t* &buffer, uint8_t* bufferEnd, uint32_t stateVersion)
+{
+	uint32_t size = 0;
+	if((size_t)(bufferEnd - buffer) >= sizeof(size)) {
+		memcpy(&size, buffer, sizeof(size));
+		buffer += sizeof(size);
+	}
+	size = (uint32_t)std::min<size_t>(size, bufferEnd - buffer);
+	LoadFromBuffer(buffer, size, stateVersion);
+	buffer += size;
+}
+
 void Snapshotable::WriteEmptyBlock(ostream* file)
 {
 	int blockSize = 0;
@@ -117,4 +152,25 @@ void Snapshotable::SkipBlock(istream* file)
 	int blockSize = 0;
 	file->read((char*)&blockSize, sizeof(blockSize));
 	file->seekg(blockSize, ios::cur);
-}
\ No newline at end of file
+}
+
+bool Snapshotable::WriteEmptyBlock(uint8_t* &buffer, uint8_t* bufferEnd)
+{
+	uint32_t blockSize = 0;
+	if((size_t)(bufferEnd - buffer) < sizeof(blockSize)) {
+		return false;
+	}
+	memcpy(buffer, &blockSize, sizeof(blockSize));
+	buffer += sizeof(blockSize);
+	return true;
+}
+
+void Snapshotable::SkipBlock(uint8_t* &buffer, uint8_t* bufferEnd)
+{
+	uint32_t blockSize = 0;
+	if((size_t)(bufferEnd - buffer) >= sizeof(blockSize)) {
+		memcpy(&blockSize, buffer, sizeof(blockSize));
+		buffer += sizeof(blockSize);
+	}
+	buffer += std::min<size_t>(blockSize, bufferEnd - buffer);
+}
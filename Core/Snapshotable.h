@@ -24,6 +24,21 @@ struct ValueInfo
 	T DefaultValue;
 };
 
+//Byte array with a write stamp for each 256-byte page (the stamps are updated by the owner whenever a page is written to)
+//Pages stamped <= SavedStamp haven't been modified since that state was saved: they are not copied when loading incrementally,
+//and when saving incrementally only a reference to them is written (a bit in the page bitmap that precedes the modified pages)
+struct PagedArrayInfo
+{
+	static constexpr uint32_t PageReferences = 0x80000000;
+
+	uint8_t* Array;
+	uint32_t ElementCount;
+	uint32_t* PageStamps;
+	uint32_t CurrentStamp;
+	uint32_t SavedStamp;
+	bool Incremental;
+};
+
 struct SnapshotInfo
 {
 	Snapshotable* Entity;
@@ -38,9 +53,9 @@ struct EmptyInfo
 class Snapshotable
 {
 private:
-	uint8_t* _stream;
-	uint32_t _position;
-	uint32_t _streamSize;
+	uint8_t* _stream = nullptr;
+	uint32_t _position = 0;
+	uint32_t _streamSize = 0;
 	uint32_t _stateVersion = 0;
 
 	bool _inBlock = false;
@@ -48,64 +63,64 @@ private:
 	uint32_t _blockSize = 0;
 	uint32_t _blockPosition = 0;
 
+	//Buffers used when saving (and when loading from an istream) - kept between calls to avoid allocating memory for every save state
+	//When loading from memory, _stream and _blockBuffer point directly to the source data instead
+	vector<uint8_t> _streamData;
+	vector<uint8_t> _blockData;
+
 	bool _saving;
 
 private:
 	void EnsureCapacity(uint32_t typeSize)
 	{
 		//Make sure the current block/stream is large enough to fit the next write
-		uint32_t oldSize;
-		uint32_t sizeRequired;
-		uint8_t *oldBuffer;
-		if(_inBlock) {
-			oldBuffer = _blockBuffer;
-			oldSize = _blockSize;
-			sizeRequired = _blockPosition + typeSize;
-		} else {
-			oldBuffer = _stream;
-			oldSize = _streamSize;
-			sizeRequired = _position + typeSize;
-		}
-
-		uint8_t *newBuffer = nullptr;
-		uint32_t newSize = oldSize * 2;
-		if(oldSize < sizeRequired) {
+		vector<uint8_t> &data = _inBlock ? _blockData : _streamData;
+		uint32_t sizeRequired = (_inBlock ? _blockPosition : _position) + typeSize;
+		if(data.size() < sizeRequired) {
+			size_t newSize = std::max<size_t>(data.size() * 2, 0x100);
 			while(newSize < sizeRequired) {
 				newSize *= 2;
 			}
+			data.resize(newSize);
 
-			newBuffer = new uint8_t[newSize];
-			memcpy(newBuffer, oldBuffer, oldSize);
-			delete[] oldBuffer;
-		}
-		
-		if(newBuffer) {
 			if(_inBlock) {
-				_blockBuffer = newBuffer;
-				_blockSize = newSize;
+				_blockBuffer = data.data();
+				_blockSize = (uint32_t)data.size();
 			} else {
-				_stream = newBuffer;
-				_streamSize = newSize;
+				_stream = data.data();
+				_streamSize = (uint32_t)data.size();
 			}
 		}
 	}
 
+	void WriteBytes(const void* source, uint32_t size)
+	{
+		EnsureCapacity(size);
+		if(_inBlock) {
+			memcpy(_blockBuffer + _blockPosition, source, size);
+			_blockPosition += size;
+		} else {
+			memcpy(_stream + _position, source, size);
+			_position += size;
+		}
+	}
+
+	uint8_t* ReadBytes(uint32_t &size)
+	{
+		//Returns a pointer to the next bytes in the block/stream and skips them (size is reduced if less data is available)
+		uint32_t &position = _inBlock ? _blockPosition : _position;
+		uint32_t length = _inBlock ? _blockSize : _streamSize;
+		uint8_t* data = (_inBlock ? _blockBuffer : _stream) + position;
+		size = std::min(size, length - position);
+		position += size;
+		return data;
+	}
+
 	template<typename T>
 	void StreamElement(T &value, T defaultValue = T())
 	{
 		if(_saving) {
-			uint8_t* bytes = (uint8_t*)&value;
-			int typeSize = sizeof(T);
-
-			EnsureCapacity(typeSize);
-
-			for(int i = 0; i < typeSize; i++) {
-				if(_inBlock) {
-					_blockBuffer[_blockPosition++] = bytes[i];
-				} else {
-					_stream[_position++] = bytes[i];
-				}
-			}
+			WriteBytes(&value, sizeof(T));
 		} else {
 			if(_inBlock) {
 				if(_blockPosition + sizeof(T) <= _blockSize) {
@@ -127,6 +142,19 @@ private:
 		}
 	}
 
+	template<typename T>
+	void StreamElements(T* elements, uint32_t count, uint32_t savedCount)
+	{
+		if(_saving) {
+			WriteBytes(elements, sizeof(T) * count);
+		} else {
+			//Load the number of elements requested, or the maximum possible (based on what is present in the save state)
+			uint32_t size = sizeof(T) * std::min(count, savedCount);
+			uint8_t* data = ReadBytes(size);
+			memcpy(elements, data, size - size % sizeof(T));
+		}
+	}
+
 	template<typename T>
 	void InternalStream(EmptyInfo<T> &info)
 	{
@@ -150,11 +178,7 @@ private:
 			memset(info.Array, 0, sizeof(T) * info.ElementCount);
 		}
 
-		//Load the number of elements requested, or the maximum possible (based on what is present in the save state)
-		for(uint32_t i = 0; i < info.ElementCount && i < count; i++) {
-			StreamElement<T>(*pointer);
-			pointer++;
-		}
+		StreamElements<T>(pointer, info.ElementCount, count);
 	}
 
 	template<typename T>
@@ -171,10 +195,85 @@ private:
 		}
 
 		//Load the number of elements requested
-		T* pointer = vector->data();
-		for(uint32_t i = 0; i < count; i++) {
-			StreamElement<T>(*pointer);
-			pointer++;
+		StreamElements<T>(vector->data(), count, count);
+	}
+
+	void InternalStream(PagedArrayInfo &info)
+	{
+		//Same format as ArrayInfo<uint8_t>, unless the count has the PageReferences flag:
+		//it is then followed by a bitmap of the pages present in the state, and by these pages
+		uint32_t pageCount = (info.ElementCount + 0xFF) >> 8;
+		uint32_t count = info.ElementCount | (_saving && info.Incremental ? PagedArrayInfo::PageReferences : 0);
+		StreamElement<uint32_t>(count);
+
+		if(_saving) {
+			if(info.Incremental) {
+				SaveModifiedPages(info, pageCount);
+			} else {
+				WriteBytes(info.Array, info.ElementCount);
+			}
+			return;
+		}
+
+		if(count & PagedArrayInfo::PageReferences) {
+			LoadModifiedPages(info, pageCount, count & ~PagedArrayInfo::PageReferences);
+			return;
+		}
+
+		uint32_t size = std::min(count, info.ElementCount);
+		uint8_t* data = ReadBytes(size);
+		if(info.Incremental && size == info.ElementCount) {
+			for(uint32_t i = 0; i < pageCount; i++) {
+				if(info.PageStamps[i] > info.SavedStamp) {
+					uint32_t start = i << 8;
+					memcpy(info.Array + start, data + start, std::min<uint32_t>(0x100, size - start));
+					info.PageStamps[i] = info.CurrentStamp;
+				}
+			}
+		} else {
+			memset(info.Array, 0, info.ElementCount);
+			memcpy(info.Array, data, size);
+			std::fill(info.PageStamps, info.PageStamps + pageCount, info.CurrentStamp);
+		}
+	}
+
+	void SaveModifiedPages(PagedArrayInfo &info, uint32_t pageCount)
+	{
+		for(uint32_t i = 0; i < pageCount; i += 8) {
+			uint8_t pageBits = 0;
+			for(uint32_t j = i; j < i + 8 && j < pageCount; j++) {
+				if(info.PageStamps[j] > info.SavedStamp) {
+					pageBits |= 1 << (j - i);
+				}
+			}
+			StreamElement<uint8_t>(pageBits);
+		}
+
+		for(uint32_t i = 0; i < pageCount; i++) {
+			if(info.PageStamps[i] > info.SavedStamp) {
+				uint32_t start = i << 8;
+				WriteBytes(info.Array + start, std::min<uint32_t>(0x100, info.ElementCount - start));
+			}
+		}
+	}
+
+	void LoadModifiedPages(PagedArrayInfo &info, uint32_t pageCount, uint32_t savedCount)
+	{
+		//Referenced pages are left as is, the caller must make sure they match the saved state
+		uint32_t savedPageCount = (savedCount + 0xFF) >> 8;
+		uint32_t bitmapSize = (savedPageCount + 7) >> 3;
+		uint8_t* pageBits = ReadBytes(bitmapSize);
+
+		for(uint32_t i = 0; i < savedPageCount && (i >> 3) < bitmapSize; i++) {
+			if(pageBits[i >> 3] & (1 << (i & 0x07))) {
+				uint32_t start = i << 8;
+				uint32_t size = std::min<uint32_t>(0x100, savedCount - start);
+				uint8_t* data = ReadBytes(size);
+				if(i < pageCount) {
+					memcpy(info.Array + start, data, std::min(size, info.ElementCount - start));
+					info.PageStamps[i] = info.CurrentStamp;
+				}
+			}
 		}
 	}
 
@@ -211,6 +310,9 @@ private:
 	void StreamStartBlock();
 	void StreamEndBlock();
 
+	void SaveToBuffer();
+	void LoadFromBuffer(uint8_t* data, uint32_t size, uint32_t stateVersion);
+
 protected:
 	virtual void StreamState(bool saving) = 0;
 
@@ -232,6 +334,12 @@ public:
 	void SaveSnapshot(ostream* file);
 	void LoadSnapshot(istream* file, uint32_t stateVersion);
 
+	//Stream-free versions, used to save/load states directly from/to memory (the buffer pointer is moved past the snapshot)
+	bool SaveSnapshot(uint8_t* &buffer, uint8_t* bufferEnd);
+	void LoadSnapshot(uint8_t* &buffer, uint8_t* bufferEnd, uint32_t stateVersion);
+
 	static void WriteEmptyBlock(ostream* file);
 	static void SkipBlock(istream* file);
+	static bool WriteEmptyBlock(uint8_t* &buffer, uint8_t* bufferEnd);
+	static void SkipBlock(uint8_t* &buffer, uint8_t* bufferEnd);
 };
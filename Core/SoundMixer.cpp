@@ -7,6 +7,7 @@
 #include "OggMixer.h"
 #include "Console.h"
 #include "BaseMapper.h"
+#include "Profiler.h"
 
 SoundMixer::SoundMixer(shared_ptr<Console> console)
 {
@@ -88,6 +89,8 @@ void SoundMixer::Reset()
 
 void SoundMixer::PlayAudioBuffer(uint32_t time)
 {
+	PROFILE_SECTION(ProfilerSection::Audio);
+
 	UpdateTargetSampleRate();
 	EndFrame(time);
 
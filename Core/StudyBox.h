@@ -100,6 +100,8 @@ protected:
 		_pageFound = true;
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		if(_processBitDelay > 0) {
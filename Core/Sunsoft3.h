@@ -25,6 +25,8 @@ protected:
 		Stream(_irqLatch, _irqEnabled, _irqCounter);
 	}
 
+	virtual bool RequiresCpuClock() override { return true; }
+
 	virtual void ProcessCpuClock() override
 	{
 		if(_irqEnabled) {
@@ -37,6 +37,8 @@ protected:
 		UpdateState();
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		_irq->ProcessCpuClock();
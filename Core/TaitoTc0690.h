@@ -34,6 +34,8 @@ protected:
 		_irqDelay = _isFlintstones ? 19 : 6;
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		if(_irqDelay > 0) {
@@ -24,6 +24,8 @@ protected:
 		RemoveRegisterRange(0xD000, 0xFFFF, MemoryOperation::Write);
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		_irq->ProcessCpuClock();
@@ -116,6 +116,8 @@ class VRC2_4 : public BaseMapper
 			}
 		}
 		
+		bool RequiresCpuClock() override { return true; }
+
 		void ProcessCpuClock() override
 		{
 			if(_variant == VRCVariant::VRC2_308) {
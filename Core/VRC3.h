@@ -28,6 +28,8 @@ protected:
 		Stream(_irqEnableOnAck, _smallCounter, _irqEnabled, _irqCounter, _irqReload);
 	}
 
+	virtual bool RequiresCpuClock() override { return true; }
+
 	virtual void ProcessCpuClock() override
 	{
 		if(_irqEnabled) {
@@ -46,10 +46,11 @@ protected:
 		}
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		_irq->ProcessCpuClock();
-		_audio->Clock();
 	}
 
 	void UpdateState()
@@ -13,16 +13,20 @@
 #include "HdData.h"
 #include "HdNesPack.h"
 #include "RotateFilter.h"
+#include "Profiler.h"
 
 VideoDecoder::VideoDecoder(shared_ptr<Console> console)
 {
 	_console = console;
 	_settings = _console->GetSettings();
+	_stopFlag = false;
+	_frameChanged = false;
 	UpdateVideoFilter();
 }
 
 VideoDecoder::~VideoDecoder()
 {
+	StopThread();
 }
 
 FrameInfo VideoDecoder::GetFrameInfo()
@@ -88,6 +92,8 @@ void VideoDecoder::UpdateVideoFilter()
 
 void VideoDecoder::DecodeFrame()
 {
+	PROFILE_SECTION(ProfilerSection::VideoFilter);
+
 	UpdateVideoFilter();
 
 	if(_hdFilterEnabled) {
@@ -104,16 +110,109 @@ void VideoDecoder::DecodeFrame()
 	}
 
 	if(_scaleFilter) {
-		outputBuffer = _scaleFilter->ApplyFilter(outputBuffer, frameInfo.Width, frameInfo.Height, _console->GetSettings()->GetPictureSettings().ScanlineIntensity);
+		outputBuffer = _scaleFilter->ApplyFilter(outputBuffer, frameInfo.Width, frameInfo.Height, _console->GetSettings()->GetPictureSettings().ScanlineIntensity, _console->GetSettings()->GetVideoFilterThreadCount());
 		frameInfo = _scaleFilter->GetFrameInfo(frameInfo);
 	}
 
 	ScreenSize screenSize;
 	GetScreenSize(screenSize, true);
 	
-	_lastFrameInfo = frameInfo;
+	_decodedFrame = outputBuffer;
+	_decodedFrameInfo = frameInfo;
+}
+
+bool VideoDecoder::SendDecodedFrame()
+{
+	_lastFrameInfo = _decodedFrameInfo;
+	return _console->GetVideoRenderer()->UpdateFrame(_decodedFrame, _decodedFrameInfo.Width, _decodedFrameInfo.Height);
+}
+
+bool VideoDecoder::IsDuplicateFrame(uint16_t *ppuOutputBuffer, HdScreenInfo *hdScreenInfo)
+{
+	if(!_lastSentPpuOutputValid || hdScreenInfo || _settings->GetVideoFilterType() != _videoFilterType) {
+		return false;
+	}
+
+	switch(_videoFilterType) {
+		//The NTSC filters' output changes every frame (the color burst phase alternates between odd and even frames)
+		case VideoFilterType::NTSC:
+		case VideoFilterType::BisqwitNtsc:
+		case VideoFilterType::BisqwitNtscHalfRes:
+		case VideoFilterType::BisqwitNtscQuarterRes:
+			return false;
+
+		default:
+			break;
+	}
+
+	return _console->GetVideoRenderer()->CanSendDuplicateFrame() && memcmp(ppuOutputBuffer, _lastSentPpuOutput.data(), PPU::PixelCount * sizeof(uint16_t)) == 0;
+}
+
+void VideoDecoder::SaveSentFrame(vector<uint16_t> &ppuOutput)
+{
+	std::swap(_lastSentPpuOutput, ppuOutput);
+	_lastSentPpuOutputValid = true;
+}
+
+void VideoDecoder::InvalidateLastFrame()
+{
+	_lastSentPpuOutputValid = false;
+}
+
+void VideoDecoder::DecodeThread()
+{
+	while(!_stopFlag) {
+		_waitForFrame.Wait();
+		if(_stopFlag) {
+			break;
+		}
+
+		if(_frameChanged) {
+			DecodeFrame();
 
-	_console->GetVideoRenderer()->UpdateFrame(outputBuffer, frameInfo.Width, frameInfo.Height);
+			//The filters reuse their buffers for the next frame, keep a copy that stays valid until the frontend is done with it
+			vector<uint32_t> &output = _threadOutput[_threadOutputIndex];
+			size_t pixelCount = (size_t)_decodedFrameInfo.Width * _decodedFrameInfo.Height;
+			if(output.size() < pixelCount) {
+				output.resize(pixelCount);
+			}
+			memcpy(output.data(), _decodedFrame, pixelCount * sizeof(uint32_t));
+			_decodedFrame = output.data();
+
+			_frameChanged = false;
+			_frameDecoded.Signal();
+		}
+	}
+}
+
+void VideoDecoder::WaitForDecode()
+{
+	while(_frameChanged) {
+		_frameDecoded.Wait();
+	}
+}
+
+void VideoDecoder::StartThread()
+{
+	if(!_decodeThread.joinable()) {
+		_stopFlag = false;
+		_frameChanged = false;
+		_framePending = false;
+		_decodeThread = std::thread(&VideoDecoder::DecodeThread, this);
+	}
+}
+
+void VideoDecoder::StopThread()
+{
+	if(_decodeThread.joinable()) {
+		WaitForDecode();
+		_stopFlag = true;
+		_waitForFrame.Signal();
+		_decodeThread.join();
+
+		//The last decoded frame is dropped, the next one will be filtered on the emulation thread
+		_framePending = false;
+	}
 }
 
 uint32_t VideoDecoder::GetFrameCount()
@@ -121,12 +220,75 @@ uint32_t VideoDecoder::GetFrameCount()
 	return _frameCount;
 }
 
+void VideoDecoder::SetDecodingDisabled(bool disabled)
+{
+	_decodingDisabled = disabled;
+}
+
+bool VideoDecoder::IsDecodingDisabled()
+{
+	return _decodingDisabled;
+}
+
 void VideoDecoder::UpdateFrameSync(void *ppuOutputBuffer, HdScreenInfo *hdScreenInfo)
 {
-	_frameNumber = _console->GetFrameCount();
-	_hdScreenInfo = hdScreenInfo;
-	_ppuOutputBuffer = (uint16_t*)ppuOutputBuffer;
-	DecodeFrame();
+	if(_decodingDisabled) {
+		//The previous frame may still be filtered on the decode thread, it reads the PPU's output buffer and HD screen info that the next frame will reuse
+		WaitForDecode();
+		_frameCount++;
+		return;
+	}
+
+	bool keepCopy = _console->GetVideoRenderer()->SupportsDuplicateFrames();
+
+	if(_settings->CheckFlag(EmulationFlags::ThreadedVideoFilter)) {
+		StartThread();
+
+		//Wait for the previous frame to be done, send it to the frontend and start filtering this one
+		WaitForDecode();
+		if(_framePending) {
+			if(_pendingDuplicate) {
+				if(_console->GetVideoRenderer()->CanSendDuplicateFrame()) {
+					_console->GetVideoRenderer()->SendDuplicateFrame();
+				}
+			} else {
+				if(SendDecodedFrame() && keepCopy) {
+					SaveSentFrame(_pendingPpuOutput);
+				}
+				_threadOutputIndex ^= 1;
+			}
+		}
+
+		_framePending = true;
+		_pendingDuplicate = IsDuplicateFrame((uint16_t*)ppuOutputBuffer, hdScreenInfo);
+		if(!_pendingDuplicate) {
+			if(keepCopy) {
+				_pendingPpuOutput.assign((uint16_t*)ppuOutputBuffer, (uint16_t*)ppuOutputBuffer + PPU::PixelCount);
+			}
+
+			_frameNumber = _console->GetFrameCount();
+			_hdScreenInfo = hdScreenInfo;
+			_ppuOutputBuffer = (uint16_t*)ppuOutputBuffer;
+			_frameChanged = true;
+			_waitForFrame.Signal();
+		}
+	} else {
+		StopThread();
+
+		if(IsDuplicateFrame((uint16_t*)ppuOutputBuffer, hdScreenInfo)) {
+			//No need to filter the frame again, and the frontend can skip uploading it
+			_console->GetVideoRenderer()->SendDuplicateFrame();
+		} else {
+			_frameNumber = _console->GetFrameCount();
+			_hdScreenInfo = hdScreenInfo;
+			_ppuOutputBuffer = (uint16_t*)ppuOutputBuffer;
+			DecodeFrame();
+			if(SendDecodedFrame() && keepCopy) {
+				_pendingPpuOutput.assign(_ppuOutputBuffer, _ppuOutputBuffer + PPU::PixelCount);
+				SaveSentFrame(_pendingPpuOutput);
+			}
+		}
+	}
 	_frameCount++;
 }
 
@@ -1,8 +1,10 @@
 #pragma once
 #include "stdafx.h"
 
+#include <thread>
 #include "EmulationSettings.h"
 #include "FrameInfo.h"
+#include "../Utilities/AutoResetEvent.h"
 
 class BaseVideoFilter;
 class ScaleFilter;
@@ -29,23 +31,59 @@ private:
 	uint32_t _frameNumber = 0;
 
 	uint32_t _frameCount = 0;
+	bool _decodingDisabled = false;
 
 	FrameInfo _lastFrameInfo;
 
+	uint32_t* _decodedFrame = nullptr;
+	FrameInfo _decodedFrameInfo = {};
+
+	//Pipelined mode: frame N is filtered on the decode thread while frame N+1 is emulated, and sent to the frontend once frame N+1 is done
+	std::thread _decodeThread;
+	AutoResetEvent _waitForFrame;
+	AutoResetEvent _frameDecoded;
+	atomic<bool> _stopFlag;
+	atomic<bool> _frameChanged;
+	bool _framePending = false;
+	vector<uint32_t> _threadOutput[2];
+	int _threadOutputIndex = 0;
+
+	//PPU output of the last frame sent to the frontend - when the next frame is identical, the frontend is told to show the previous frame again instead
+	vector<uint16_t> _lastSentPpuOutput;
+	vector<uint16_t> _pendingPpuOutput;
+	bool _lastSentPpuOutputValid = false;
+	bool _pendingDuplicate = false;
+
 	VideoFilterType _videoFilterType = VideoFilterType::None;
 	std::unique_ptr<BaseVideoFilter> _videoFilter;
 	std::shared_ptr<ScaleFilter> _scaleFilter;
 	std::shared_ptr<RotateFilter> _rotateFilter;
 
 	void UpdateVideoFilter();
+	void DecodeThread();
+	bool SendDecodedFrame();
+	bool IsDuplicateFrame(uint16_t *ppuOutputBuffer, HdScreenInfo *hdScreenInfo);
+	void SaveSentFrame(vector<uint16_t> &ppuOutput);
+
 public:
 	VideoDecoder(std::shared_ptr<Console> console);
 	~VideoDecoder();
 
 	void DecodeFrame();
 
+	void StartThread();
+	void StopThread();
+	void WaitForDecode();
+
 	uint32_t GetFrameCount();
 
+	//Frames that will never be displayed (e.g run-ahead) don't need to go through the video filters at all
+	void SetDecodingDisabled(bool disabled);
+	bool IsDecodingDisabled();
+
+	//The next frame is always filtered and sent in full (e.g after the video settings changed)
+	void InvalidateLastFrame();
+
 	FrameInfo GetFrameInfo();
 	void GetScreenSize(ScreenSize &size, bool ignoreScale);
 
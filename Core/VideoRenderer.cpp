@@ -2,7 +2,9 @@
 #include "VideoRenderer.h"
 #include "VideoDecoder.h"
 
-void VideoRenderer::UpdateFrame(void *frameBuffer, uint32_t width, uint32_t height)
+VideoRenderer* VideoRenderer::_lastFrameSender = nullptr;
+
+bool VideoRenderer::UpdateFrame(void *frameBuffer, uint32_t width, uint32_t height)
 {
 	if(!_skipMode && _sendFrame) {
 		//Use Blargg's NTSC filter's max size as a minimum resolution, to prevent changing resolution too often
@@ -19,7 +21,32 @@ void VideoRenderer::UpdateFrame(void *frameBuffer, uint32_t width, uint32_t heig
 		}
 
 		_sendFrame(frameBuffer, width, height, sizeof(uint32_t) * width);
+		_lastFrameSender = this;
+		_lastFrameWidth = width;
+		_lastFrameHeight = height;
+		return true;
+	}
+	return false;
+}
+
+bool VideoRenderer::SupportsDuplicateFrames()
+{
+	if(!_canDupeChecked) {
+		bool canDupe = false;
+		_canDupe = _retroEnv != nullptr && _retroEnv(RETRO_ENVIRONMENT_GET_CAN_DUPE, &canDupe) && canDupe;
+		_canDupeChecked = true;
 	}
+	return _canDupe;
+}
+
+bool VideoRenderer::CanSendDuplicateFrame()
+{
+	return !_skipMode && _sendFrame && _lastFrameSender == this && SupportsDuplicateFrames();
+}
+
+void VideoRenderer::SendDuplicateFrame()
+{
+	_sendFrame(nullptr, _lastFrameWidth, _lastFrameHeight, sizeof(uint32_t) * _lastFrameWidth);
 }
 
 void VideoRenderer::SetVideoCallback(retro_video_refresh_t sendFrame)
@@ -18,6 +18,16 @@ private:
 	bool _skipMode = false;
 	int32_t _previousHeight = -1;
 	int32_t _previousWidth = -1;
+
+	//Frontends that support it can be told to show the previous frame again instead of receiving an identical copy
+	bool _canDupeChecked = false;
+	bool _canDupe = false;
+	uint32_t _lastFrameWidth = 0;
+	uint32_t _lastFrameHeight = 0;
+
+	//Last renderer that sent a frame to the frontend (e.g the run-ahead console's renderer and the main console's renderer can take turns)
+	static VideoRenderer* _lastFrameSender;
+
 public:
 	VideoRenderer(std::shared_ptr<Console> console, retro_environment_t retroEnv)
 	{
@@ -25,9 +35,21 @@ public:
 		_retroEnv = retroEnv;
 	}
 
-	~VideoRenderer() { }
+	~VideoRenderer()
+	{
+		if(_lastFrameSender == this) {
+			_lastFrameSender = nullptr;
+		}
+	}
+
+	//Returns true if the frame was sent to the frontend
+	bool UpdateFrame(void *frameBuffer, uint32_t width, uint32_t height);
+
+	bool SupportsDuplicateFrames();
 
-	void UpdateFrame(void *frameBuffer, uint32_t width, uint32_t height);
+	//True when the frontend is currently showing the last frame sent by this renderer and supports duplicate frames
+	bool CanSendDuplicateFrame();
+	void SendDuplicateFrame();
 	
 	void GetSystemAudioVideoInfo(retro_system_av_info &info, int32_t maxWidth = 0, int32_t maxHeight = 0)
 	{
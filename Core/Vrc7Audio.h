@@ -14,18 +14,28 @@ private:
 	bool _muted;
 
 protected:
-	void ClockAudio() override
+	void RunAudio(uint32_t startCycle, uint32_t endCycle) override
 	{
-		if(_clockTimer == 0) {
-			_clockTimer = ((double)_console->GetCpu()->GetClockRate(_console->GetModel())) / 49716;
-		}
+		//The OPLL outputs a sample every ~36 CPU cycles (49716 Hz), only those cycles need to be processed
+		double period = ((double)_console->GetCpu()->GetClockRate(_console->GetModel())) / 49716;
+		uint32_t cycle = startCycle;
+		while(cycle < endCycle) {
+			if(_clockTimer == 0) {
+				_clockTimer = period;
+			}
+
+			//Number of cycles until the timer reaches 0 (the timer is decremented by 1 each cycle)
+			uint32_t cyclesToSample = (uint32_t)std::ceil(_clockTimer);
+			if(cycle + cyclesToSample > endCycle) {
+				_clockTimer -= endCycle - cycle;
+				break;
+			}
 
-		_clockTimer--;
-		if(_clockTimer <= 0) {
+			cycle += cyclesToSample;
 			int16_t output = _opllEmulator->GetOutput();
-			_console->GetApu()->AddExpansionAudioDelta(AudioChannel::VRC7, _muted ? 0 : (output - _previousOutput));
+			_console->GetApu()->AddExpansionAudioDelta(AudioChannel::VRC7, _muted ? 0 : (output - _previousOutput), cycle - 1);
 			_previousOutput = output;
-			_clockTimer = ((double)_console->GetCpu()->GetClockRate(_console->GetModel())) / 49716;
+			_clockTimer = period;
 		}
 	}
 
@@ -45,15 +55,18 @@ public:
 		_muted = false;
 		_clockTimer = 0;
 		_opllEmulator.reset(new Vrc7Opll::OpllEmulator());
+		_console->GetApu()->SetExpansionAudio(this);
 	}
 
 	void SetMuteAudio(bool muted)
 	{
+		_console->GetApu()->Run();
 		_muted = muted;
 	}
 
 	void WriteReg(uint16_t addr, uint8_t value)
 	{
+		_console->GetApu()->Run();
 		switch(addr & 0xF030) {
 			case 0x9010:
 				_currentReg = value;
@@ -75,6 +75,8 @@ protected:
 		Stream(_prgChrSelectBit);
 	}
 
+	bool RequiresCpuClock() override { return true; }
+
 	void ProcessCpuClock() override
 	{
 		VsControlManager* controlManager = dynamic_cast<VsControlManager*>(_console->GetControlManager());
@@ -0,0 +1,561 @@
+//Headless frame-throughput benchmark
+//Loads each ROM through Console::Initialize and runs it via Console::RunSingleFrame with video/audio output in skip mode
+//Build with "make bench" (or "make bench PROFILER=1" on a clean tree to get the per-subsystem time split)
+#include "../stdafx.h"
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include "../libretro.h"
+#include "../../Core/Console.h"
+#include "../../Core/CPU.h"
+#include "../../Core/EmulationSettings.h"
+#include "../../Core/GameDatabase.h"
+#include "../../Core/HdData.h"
+#include "../../Core/HdPackLoader.h"
+#include "../../Core/OpllEmulator.h"
+#include "../../Core/SoundMixer.h"
+#include "../../Core/VideoDecoder.h"
+#include "../../Core/VideoRenderer.h"
+#include "../../Core/VirtualFile.h"
+#include "../../Core/Profiler.h"
+#include "../../Utilities/FolderUtilities.h"
+#include "../../Utilities/CRC32.h"
+#include "../../Utilities/HexUtilities.h"
+
+//Include game database as a byte array (representing the MesenDB.txt file)
+#include "../MesenDB.inc"
+
+//Referenced by the core (used to initialize the VS DualSystem slave console)
+retro_environment_t env_cb = nullptr;
+
+struct BenchEntry
+{
+	string Path;
+	uint32_t FrameCount;
+};
+
+struct BenchOptions
+{
+	uint32_t FrameCount = 3600;
+	uint32_t WarmupFrameCount = 60;
+	VideoFilterType Filter = VideoFilterType::None;
+	bool LazyPpu = false;
+	bool ThreadedFilter = false;
+	bool SkipFrames = false;
+	bool HdPacks = false;
+	bool HdLookup = false;
+	bool HdCompile = false;
+	bool CpuCompare = false;
+	bool OpllCompare = false;
+	uint32_t HdTileCacheSize = 0;
+	uint32_t FilterThreadCount = 0;
+	string HomeFolder = ".";
+	vector<BenchEntry> Roms;
+};
+
+static bool BenchEnvironment(unsigned cmd, void *data)
+{
+	//Accept nothing - the benchmark runs without a frontend
+	return false;
+}
+
+static bool ParseFilter(string name, VideoFilterType &filter)
+{
+	static const std::pair<const char*, VideoFilterType> filters[] = {
+		{ "none", VideoFilterType::None }, { "ntsc", VideoFilterType::NTSC },
+		{ "bisqwit2x", VideoFilterType::BisqwitNtscQuarterRes }, { "bisqwit4x", VideoFilterType::BisqwitNtscHalfRes }, { "bisqwit8x", VideoFilterType::BisqwitNtsc },
+		{ "xbrz2x", VideoFilterType::xBRZ2x }, { "xbrz3x", VideoFilterType::xBRZ3x }, { "xbrz4x", VideoFilterType::xBRZ4x }, { "xbrz5x", VideoFilterType::xBRZ5x }, { "xbrz6x", VideoFilterType::xBRZ6x },
+		{ "hq2x", VideoFilterType::HQ2x }, { "hq3x", VideoFilterType::HQ3x }, { "hq4x", VideoFilterType::HQ4x },
+		{ "scale2x", VideoFilterType::Scale2x }, { "scale3x", VideoFilterType::Scale3x }, { "scale4x", VideoFilterType::Scale4x },
+		{ "2xsai", VideoFilterType::_2xSai }, { "super2xsai", VideoFilterType::Super2xSai }, { "supereagle", VideoFilterType::SuperEagle },
+		{ "prescale2x", VideoFilterType::Prescale2x }, { "prescale4x", VideoFilterType::Prescale4x }, { "prescale10x", VideoFilterType::Prescale10x },
+		{ "raw", VideoFilterType::Raw }
+	};
+
+	std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+	for(auto &entry : filters) {
+		if(name == entry.first) {
+			filter = entry.second;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool LoadCorpus(string listFile, BenchOptions &options)
+{
+	//Each line is "<rom path> [frame count]" - paths are relative to the list file's folder, lines starting with # are ignored
+	ifstream list(listFile);
+	if(!list) {
+		return false;
+	}
+
+	string folder = FolderUtilities::GetFolderName(listFile);
+	string line;
+	while(std::getline(list, line)) {
+		std::stringstream ss(line);
+		BenchEntry entry = { "", options.FrameCount };
+		if(!(ss >> entry.Path) || entry.Path[0] == '#') {
+			continue;
+		}
+		ss >> entry.FrameCount;
+		entry.Path = FolderUtilities::CombinePath(folder, entry.Path);
+		options.Roms.push_back(entry);
+	}
+	return true;
+}
+
+static void PrintUsage()
+{
+	std::cout << "Usage: mesen_bench [options] <rom>..." << std::endl;
+	std::cout << "  -f <count>     Number of measured frames per ROM (default: 3600)" << std::endl;
+	std::cout << "  -w <count>     Number of warmup frames per ROM (default: 60)" << std::endl;
+	std::cout << "  -l <file>      Read the ROM list from a corpus file (see bench/corpus.txt)" << std::endl;
+	std::cout << "  -v <filter>    Video filter to apply (none, ntsc, bisqwit2x/4x/8x, xbrz2x-6x, hq2x-4x, scale2x-4x, prescale2x/4x/10x, raw)" << std::endl;
+	std::cout << "  -lazyppu       Enable lazy PPU scheduling" << std::endl;
+	std::cout << "  -async         Run the video filter on its own thread (one frame of latency)" << std::endl;
+	std::cout << "  -skip          Run every frame as a skipped frame (no video decoding, no PPU pixel output)" << std::endl;
+	std::cout << "  -t <count>     Number of threads used by the video filters (default: one per core)" << std::endl;
+	std::cout << "  -hd            Load the ROM's HD pack (from <home>/HdPacks)" << std::endl;
+	std::cout << "  -hdlookup      Benchmark the HD pack's tile lookups instead of running frames" << std::endl;
+	std::cout << "  -cpucompare    Run each ROM with the fused and the original CPU dispatch, and fail on the first frame where they differ" << std::endl;
+	std::cout << "  -opllcompare   Run random VRC7 register writes through the scalar and AVX2 OPLL code, and fail on the first sample where they differ (no ROM needed)" << std::endl;
+	std::cout << "  -hdcache <MB>  Decode the HD pack's tiles on demand, keeping up to <MB> of them in memory" << std::endl;
+	std::cout << "  -hdcompile     Compile the ROM's HD pack to hires.bin and compare its load time with hires.txt" << std::endl;
+	std::cout << "  -home <folder> Home folder used for batteries, BIOS and HD packs (default: current folder)" << std::endl;
+}
+
+//Tile key hash and table used by HD packs before HdTileIndex, kept as the baseline for -hdlookup
+struct LegacyTileKeyHash
+{
+	size_t operator()(const HdTileKey &key) const
+	{
+		uint64_t longKey = key.TileIndex | ((uint64_t)key.PaletteColors << 32);
+		const uint8_t* data = key.IsChrRamTile ? (const uint8_t*)&key.PaletteColors : (const uint8_t*)&longKey;
+		size_t len = key.IsChrRamTile ? 20 : sizeof(longKey);
+
+		uint32_t result = 0;
+		for(size_t i = 0; i < len; i += 4) {
+			uint32_t chunk;
+			memcpy(&chunk, data + i, sizeof(uint32_t));
+			result += chunk;
+			result = (result << 2) | (result >> 30);
+		}
+		return result;
+	}
+};
+
+static void RunHdLookupBenchmark(std::shared_ptr<HdPackData> hdData)
+{
+	if(!hdData || hdData->Tiles.empty()) {
+		std::cout << "  No HD pack loaded" << std::endl;
+		return;
+	}
+
+	std::unordered_map<HdTileKey, vector<HdPackTileInfo*>, LegacyTileKeyHash> legacyMap;
+	for(unique_ptr<HdPackTileInfo> &tile : hdData->Tiles) {
+		legacyMap[tile->GetKey(false)].push_back(tile.get());
+		if(tile->DefaultTile) {
+			legacyMap[tile->GetKey(true)].push_back(tile.get());
+		}
+	}
+
+	//Each tile is looked up as-is (exact match), with another palette (default tile or miss) and as an unknown tile (miss)
+	vector<HdTileKey> keys;
+	for(unique_ptr<HdPackTileInfo> &tile : hdData->Tiles) {
+		HdTileKey key = tile->GetKey(false);
+		keys.push_back(key);
+		key.PaletteColors ^= 0x00102030;
+		keys.push_back(key);
+		key.TileIndex += 0x100000;
+		key.TileData[0] ^= 0x5A;
+		keys.push_back(key);
+	}
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(0));
+
+	uint32_t passCount = std::max<uint32_t>(1, 10000000 / (uint32_t)keys.size());
+	uint64_t legacyChecksum = 0;
+	auto start = std::chrono::high_resolution_clock::now();
+	for(uint32_t i = 0; i < passCount; i++) {
+		for(HdTileKey &key : keys) {
+			auto result = legacyMap.find(key);
+			if(result == legacyMap.end()) {
+				result = legacyMap.find(key.GetKey(true));
+			}
+			if(result != legacyMap.end()) {
+				legacyChecksum += (uintptr_t)result->second[0] + result->second.size();
+			}
+		}
+	}
+	double legacyTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	uint64_t checksum = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for(uint32_t i = 0; i < passCount; i++) {
+		for(HdTileKey &key : keys) {
+			vector<HdPackTileInfo*>* tiles = hdData->TileByKey.FindMatch(key);
+			if(tiles) {
+				checksum += (uintptr_t)(*tiles)[0] + tiles->size();
+			}
+		}
+	}
+	double time = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	double lookupCount = (double)passCount * keys.size();
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "  " << hdData->TileByKey.GetKeyCount() << " tile keys, " << lookupCount / 1000000 << "M lookups" << std::endl;
+	std::cout << "  unordered_map: " << (lookupCount / legacyTime / 1000000) << "M lookups/s" << std::endl;
+	std::cout << "  HdTileIndex:   " << (lookupCount / time / 1000000) << "M lookups/s (" << (legacyTime / time) << "x)" << std::endl;
+	if(checksum != legacyChecksum) {
+		std::cout << "  Lookup results differ!" << std::endl;
+	}
+}
+
+static bool RunHdCompile(BenchEntry &entry)
+{
+	VirtualFile romFile(entry.Path);
+	std::cout << FolderUtilities::GetFilename(entry.Path, true) << ": HD pack compilation" << std::endl;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	if(!HdPackLoader::CompileHdPack(romFile)) {
+		std::cout << "  could not compile HD pack" << std::endl;
+		return false;
+	}
+	double compileTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	//Loading from the definition file's path always parses hires.txt and decodes the PNG files
+	string romName = FolderUtilities::GetFilename(romFile.GetFileName(), false);
+	string definitionFile = FolderUtilities::CombinePath(FolderUtilities::CombinePath(FolderUtilities::GetHdPackFolder(), romName), "hires.txt");
+	start = std::chrono::high_resolution_clock::now();
+	unique_ptr<HdPackData> textData(new HdPackData());
+	bool textLoaded = HdPackLoader::LoadHdNesPack(definitionFile, *textData);
+	double textTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	start = std::chrono::high_resolution_clock::now();
+	unique_ptr<HdPackData> compiledData(new HdPackData());
+	bool compiledLoaded = HdPackLoader::LoadHdNesPack(romFile, *compiledData);
+	double compiledTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+	if(!textLoaded || !compiledLoaded || !compiledData->CompiledPack) {
+		std::cout << "  could not load the compiled HD pack" << std::endl;
+		return false;
+	}
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "  " << compiledData->Tiles.size() << " tiles, compiled in " << (compileTime * 1000) << "ms (" << (compiledData->CompiledPack->GetSize() / 1024) << " KB)" << std::endl;
+	std::cout << "  hires.txt: " << (textTime * 1000) << "ms" << std::endl;
+	std::cout << "  hires.bin: " << (compiledTime * 1000) << "ms (" << (textTime / compiledTime) << "x)" << std::endl;
+	return true;
+}
+
+static std::shared_ptr<Console> LoadConsole(BenchEntry &entry, BenchOptions &options)
+{
+	std::shared_ptr<Console> console(new Console());
+	console->Init(BenchEnvironment);
+
+	EmulationSettings* settings = console->GetSettings();
+	settings->SetFlags(EmulationFlags::FdsAutoLoadDisk);
+	if(options.LazyPpu) {
+		settings->SetFlags(EmulationFlags::LazyPpuScheduling);
+	}
+	if(options.ThreadedFilter) {
+		settings->SetFlags(EmulationFlags::ThreadedVideoFilter);
+	}
+	if(options.HdPacks || options.HdLookup) {
+		settings->SetFlags(EmulationFlags::UseHdPacks);
+	}
+	settings->SetSampleRate(48000);
+	settings->SetMasterVolume(10.0);
+	settings->SetVideoFilterType(options.Filter);
+	settings->SetVideoFilterThreadCount(options.FilterThreadCount);
+	settings->SetHdPackTileCacheSize(options.HdTileCacheSize);
+	settings->SetControllerType(0, ControllerType::StandardController);
+	settings->SetControllerType(1, ControllerType::StandardController);
+
+	VirtualFile romFile(entry.Path);
+	if(!console->Initialize(romFile)) {
+		std::cout << entry.Path << ": could not load ROM" << std::endl;
+		console->Release(true);
+		return nullptr;
+	}
+	return console;
+}
+
+static uint32_t GetStateCrc(std::shared_ptr<Console> &console)
+{
+	std::stringstream state;
+	console->SaveState(state);
+	string stateData = state.str();
+	return CRC32::GetCRC((uint8_t*)stateData.data(), stateData.size());
+}
+
+static string GetCpuStateText(State &state)
+{
+	std::stringstream out;
+	out << "PC:" << HexUtilities::ToHex(state.PC) << " A:" << HexUtilities::ToHex(state.A) << " X:" << HexUtilities::ToHex(state.X) << " Y:" << HexUtilities::ToHex(state.Y);
+	out << " SP:" << HexUtilities::ToHex(state.SP) << " P:" << HexUtilities::ToHex(state.PS) << " CYC:" << state.CycleCount;
+	return out.str();
+}
+
+//Runs the ROM on two consoles, one with each CPU dispatch, and compares the CPU's registers and cycle count and the whole emulation state after every frame
+static bool RunCpuCompare(BenchEntry &entry, BenchOptions &options)
+{
+	std::shared_ptr<Console> consoles[2] = { LoadConsole(entry, options), LoadConsole(entry, options) };
+	if(!consoles[0] || !consoles[1]) {
+		return false;
+	}
+	consoles[0]->GetCpu()->SetLegacyDispatch(false);
+	consoles[1]->GetCpu()->SetLegacyDispatch(true);
+
+	for(std::shared_ptr<Console> &console : consoles) {
+		console->GetVideoRenderer()->SetSkipMode(true);
+		console->GetSoundMixer()->SetSkipMode(true);
+	}
+
+	bool result = true;
+	uint32_t frameCount = options.WarmupFrameCount + entry.FrameCount;
+	for(uint32_t i = 0; i < frameCount && result; i++) {
+		State states[2];
+		for(int j = 0; j < 2; j++) {
+			consoles[j]->RunSingleFrame();
+			consoles[j]->GetCpu()->GetState(states[j]);
+		}
+
+		string cpuStates[2] = { GetCpuStateText(states[0]), GetCpuStateText(states[1]) };
+		if(cpuStates[0] != cpuStates[1] || GetStateCrc(consoles[0]) != GetStateCrc(consoles[1])) {
+			std::cout << FolderUtilities::GetFilename(entry.Path, true) << ": CPU dispatch mismatch at frame " << i << std::endl;
+			std::cout << "  fused:  " << cpuStates[0] << std::endl;
+			std::cout << "  legacy: " << cpuStates[1] << std::endl;
+			result = false;
+		}
+	}
+
+	if(result) {
+		std::cout << FolderUtilities::GetFilename(entry.Path, true) << ": " << frameCount << " frames, fused and legacy CPU dispatch match (state CRC: " << HexUtilities::ToHex(GetStateCrc(consoles[0])) << ")" << std::endl;
+	}
+
+	for(std::shared_ptr<Console> &console : consoles) {
+		console->Release(true);
+	}
+	return result;
+}
+
+//Feeds the same random register writes to two OPLL emulators, one using calc_avx2 and one using the scalar calc, and compares every sample
+static bool RunOpllCompare(BenchOptions &options)
+{
+	Vrc7Opll::OpllEmulator opll[2];
+	opll[0].SetSimdEnabled(false);
+	if(!opll[1].SetSimdEnabled(true)) {
+		std::cout << "AVX2 is not supported on this CPU, nothing to compare" << std::endl;
+		return true;
+	}
+
+	//Roughly one NTSC frame worth of OPLL samples (3579545 / 72 / 60)
+	const uint32_t samplesPerFrame = 829;
+	const uint32_t registers[] = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35 };
+	std::mt19937 random(12345);
+	uint64_t sampleCount = 0;
+	uint32_t checksum = 0;
+
+	uint32_t frameCount = options.WarmupFrameCount + options.FrameCount;
+	for(uint32_t i = 0; i < frameCount; i++) {
+		uint32_t writeCount = random() % 8;
+		for(uint32_t j = 0; j < writeCount; j++) {
+			uint32_t reg = registers[random() % (sizeof(registers) / sizeof(registers[0]))];
+			uint32_t value = random() & 0xFF;
+			opll[0].WriteReg(reg, value);
+			opll[1].WriteReg(reg, value);
+		}
+		if(i % 600 == 300) {
+			//Mute a few channels for a while to cover the channel mask
+			uint32_t mask = random() & 0x3F;
+			opll[0].SetMask(mask);
+			opll[1].SetMask(mask);
+		}
+
+		for(uint32_t j = 0; j < samplesPerFrame; j++) {
+			int32_t scalar = opll[0].calc();
+			int32_t avx2 = opll[1].calc();
+			if(scalar != avx2) {
+				std::cout << "OPLL output mismatch at frame " << i << ", sample " << j << ": scalar " << scalar << ", AVX2 " << avx2 << std::endl;
+				return false;
+			}
+			checksum = checksum * 31 + (uint32_t)scalar;
+			sampleCount++;
+		}
+	}
+
+	std::cout << "OPLL: " << sampleCount << " samples, scalar and AVX2 output match (checksum: " << HexUtilities::ToHex(checksum) << ")" << std::endl;
+	return true;
+}
+
+static bool RunBenchmark(BenchEntry &entry, BenchOptions &options)
+{
+	std::shared_ptr<Console> console = LoadConsole(entry, options);
+	if(!console) {
+		return false;
+	}
+
+	if(options.HdLookup) {
+		std::cout << FolderUtilities::GetFilename(entry.Path, true) << ": HD tile lookups" << std::endl;
+		RunHdLookupBenchmark(console->GetHdData());
+		console->Release(true);
+		return true;
+	}
+
+	//Nothing is sent to a frontend, but the video filter and audio pipeline still run
+	console->GetVideoRenderer()->SetSkipMode(true);
+	console->GetSoundMixer()->SetSkipMode(true);
+	if(options.SkipFrames) {
+		//Same as frameskip/fast-forward/run-ahead frames in the libretro core
+		console->GetVideoDecoder()->SetDecodingDisabled(true);
+	}
+
+	for(uint32_t i = 0; i < options.WarmupFrameCount; i++) {
+		console->RunSingleFrame();
+	}
+
+#ifdef MESEN_PROFILER
+	Profiler::Reset();
+#endif
+
+	uint64_t startCycle = console->GetCpu()->GetCycleCount();
+	auto start = std::chrono::high_resolution_clock::now();
+	for(uint32_t i = 0; i < entry.FrameCount; i++) {
+		console->RunSingleFrame();
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+	uint64_t cycleCount = console->GetCpu()->GetCycleCount() - startCycle;
+
+	//CRC of the final emulation state, to make sure optimizations don't change the emulation's results
+	uint32_t stateCrc = GetStateCrc(console);
+
+	double fps = entry.FrameCount / elapsed;
+	double nativeFps = console->GetModel() == NesModel::NTSC ? NES_NTSC_FPS : NES_PAL_FPS;
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << FolderUtilities::GetFilename(entry.Path, true) << ": " << entry.FrameCount << " frames in " << elapsed << "s" << std::endl;
+	std::cout << "  " << fps << " fps (" << (fps / nativeFps * 100) << "% speed), " << (cycleCount / elapsed / 1000000) << "M CPU cycles/s, state CRC: " << HexUtilities::ToHex(stateCrc) << std::endl;
+
+	std::shared_ptr<HdPackData> hdData = console->GetHdData();
+	if(hdData && hdData->BitmapCache) {
+		std::cout << "  HD tile cache: " << hdData->BitmapCache->GetDecodedTileCount() << " of " << hdData->Tiles.size() << " tiles decoded (" << (hdData->BitmapCache->GetSize() / 1024) << " KB)" << std::endl;
+	}
+
+#ifdef MESEN_PROFILER
+	static const char* sectionNames[(int)ProfilerSection::Count] = { "CPU::Exec", "PPU::Exec", "APU::Run", "Video filter", "Audio pipeline" };
+	uint64_t totalTime = (uint64_t)(elapsed * 1000000000);
+	for(int i = 0; i < (int)ProfilerSection::Count; i++) {
+		uint64_t time = Profiler::GetTime((ProfilerSection)i);
+		std::cout << "  " << std::left << std::setw(16) << sectionNames[i] << std::right << std::setw(10) << (time / 1000000.0) << "ms " << std::setw(6) << (time * 100.0 / totalTime) << "% " << std::setw(12) << Profiler::GetCallCount((ProfilerSection)i) << " calls" << std::endl;
+	}
+#endif
+
+	console->Release(true);
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	BenchOptions options;
+	vector<string> romPaths;
+	string corpusFile;
+
+	for(int i = 1; i < argc; i++) {
+		string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if(arg == "-f" && hasValue) {
+			options.FrameCount = (uint32_t)std::max(1, atoi(argv[++i]));
+		} else if(arg == "-w" && hasValue) {
+			options.WarmupFrameCount = (uint32_t)std::max(0, atoi(argv[++i]));
+		} else if(arg == "-l" && hasValue) {
+			corpusFile = argv[++i];
+		} else if(arg == "-lazyppu") {
+			options.LazyPpu = true;
+		} else if(arg == "-async") {
+			options.ThreadedFilter = true;
+		} else if(arg == "-skip") {
+			options.SkipFrames = true;
+		} else if(arg == "-t" && hasValue) {
+			options.FilterThreadCount = (uint32_t)std::max(0, atoi(argv[++i]));
+		} else if(arg == "-hd") {
+			options.HdPacks = true;
+		} else if(arg == "-hdlookup") {
+			options.HdLookup = true;
+		} else if(arg == "-cpucompare") {
+			options.CpuCompare = true;
+		} else if(arg == "-opllcompare") {
+			options.OpllCompare = true;
+		} else if(arg == "-hdcache" && hasValue) {
+			options.HdTileCacheSize = (uint32_t)std::max(0, atoi(argv[++i]));
+		} else if(arg == "-hdcompile") {
+			options.HdCompile = true;
+		} else if(arg == "-home" && hasValue) {
+			options.HomeFolder = argv[++i];
+		} else if(arg == "-v" && hasValue) {
+			if(!ParseFilter(argv[++i], options.Filter)) {
+				std::cout << "Unknown video filter: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if(arg[0] == '-') {
+			PrintUsage();
+			return 1;
+		} else {
+			romPaths.push_back(arg);
+		}
+	}
+
+	if(!corpusFile.empty() && !LoadCorpus(corpusFile, options)) {
+		std::cout << "Could not open corpus file: " << corpusFile << std::endl;
+		return 1;
+	}
+	for(string &path : romPaths) {
+		options.Roms.push_back({ path, options.FrameCount });
+	}
+
+	if(options.OpllCompare) {
+		return RunOpllCompare(options) ? 0 : 1;
+	}
+
+	if(options.Roms.empty()) {
+		PrintUsage();
+		return 1;
+	}
+
+	FolderUtilities::SetHomeFolder(options.HomeFolder);
+
+	std::stringstream databaseData;
+	databaseData.write((const char*)MesenDatabase, sizeof(MesenDatabase));
+	GameDatabase::LoadGameDb(databaseData);
+
+#ifndef MESEN_PROFILER
+	std::cout << "Per-subsystem timing is disabled (rebuild with PROFILER=1 to enable it)" << std::endl;
+#endif
+
+	int failedCount = 0;
+	double totalTime = 0;
+	uint32_t totalFrames = 0;
+	for(BenchEntry &entry : options.Roms) {
+		auto start = std::chrono::high_resolution_clock::now();
+		if(options.HdCompile) {
+			if(!RunHdCompile(entry)) {
+				failedCount++;
+			}
+		} else if(options.CpuCompare) {
+			if(!RunCpuCompare(entry, options)) {
+				failedCount++;
+			}
+		} else if(RunBenchmark(entry, options)) {
+			totalFrames += entry.FrameCount + options.WarmupFrameCount;
+			totalTime += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+		} else {
+			failedCount++;
+		}
+	}
+
+	if(options.Roms.size() > 1 && totalTime > 0 && !options.HdLookup && !options.HdCompile && !options.CpuCompare) {
+		std::cout << "Total: " << totalFrames << " frames in " << totalTime << "s (" << (totalFrames / totalTime) << " fps)" << std::endl;
+	}
+
+	return failedCount > 0 ? 1 : 0;
+}
@@ -17,6 +17,9 @@
 #include "../Core/DebuggerTypes.h"
 #include "../Core/GameDatabase.h"
 #include "../Core/SoundMixer.h"
+#include "../Core/RewindManager.h"
+#include "../Core/RunAheadManager.h"
+#include "../Core/VirtualFile.h"
 #include "../Utilities/FolderUtilities.h"
 #include "../Utilities/HexUtilities.h"
 
@@ -49,12 +52,27 @@ static int32_t _saveStateSize = -1;
 static bool _shiftButtonsClockwise = false;
 static int32_t _audioSampleRate = 48000;
 
+//Frame skipping, driven by the frontend's audio buffer occupancy
+enum class FrameSkipMode { Disabled, Auto, Threshold };
+static FrameSkipMode _frameSkipMode = FrameSkipMode::Disabled;
+static uint32_t _frameSkipThreshold = 33;
+static uint32_t _frameSkipMaxCount = 3;
+static uint32_t _skippedFrames = 0;
+static bool _audioBufferActive = false;
+static uint32_t _audioBufferOccupancy = 0;
+static bool _audioBufferUnderrunLikely = false;
+static bool _updateAudioLatency = false;
+
 //Include game database as a byte array (representing the MesenDB.txt file)
 #include "MesenDB.inc"
 
 static std::shared_ptr<Console> _console;
 static std::unique_ptr<LibretroKeyManager> _keyManager;
 static std::unique_ptr<LibretroMessageManager> _messageManager;
+static std::unique_ptr<RewindManager> _rewindManager;
+static std::unique_ptr<RunAheadManager> _runAheadManager;
+static VirtualFile _loadedRom;
+static retro_video_refresh_t _sendFrame = nullptr;
 
 static constexpr const char* MesenNtscFilter = "mesen_ntsc_filter";
 static constexpr const char* MesenPalette = "mesen_palette";
@@ -72,6 +90,8 @@ static constexpr const char* MesenControllerTurboSpeed = "mesen_controllerturbos
 static constexpr const char* MesenFdsAutoSelectDisk = "mesen_fdsautoinsertdisk";
 static constexpr const char* MesenFdsFastForwardLoad = "mesen_fdsfastforwardload";
 static constexpr const char* MesenHdPacks = "mesen_hdpacks";
+static constexpr const char* MesenHdPackTileCache = "mesen_hdpacks_tile_cache";
+static constexpr const char* MesenHdPackCompile = "mesen_hdpacks_compile";
 static constexpr const char* MesenScreenRotation = "mesen_screenrotation";
 static constexpr const char* MesenFakeStereo = "mesen_fake_stereo";
 static constexpr const char* MesenMuteTriangleUltrasonic = "mesen_mute_triangle_ultrasonic";
@@ -80,6 +100,15 @@ static constexpr const char* MesenSwapDutyCycle = "mesen_swap_duty_cycle";
 static constexpr const char* MesenDisableNoiseModeFlag = "mesen_disable_noise_mode_flag";
 static constexpr const char* MesenShiftButtonsClockwise = "mesen_shift_buttons_clockwise";
 static constexpr const char* MesenAudioSampleRate = "mesen_audio_sample_rate";
+static constexpr const char* MesenLazyPpu = "mesen_lazy_ppu";
+static constexpr const char* MesenRewind = "mesen_rewind";
+static constexpr const char* MesenRewindBufferSize = "mesen_rewind_buffer_size";
+static constexpr const char* MesenRunAhead = "mesen_run_ahead";
+static constexpr const char* MesenThreadedVideoFilter = "mesen_threaded_video_filter";
+static constexpr const char* MesenVideoFilterThreads = "mesen_video_filter_threads";
+static constexpr const char* MesenFrameSkip = "mesen_frameskip";
+static constexpr const char* MesenFrameSkipThreshold = "mesen_frameskip_threshold";
+static constexpr const char* MesenFrameSkipMaxCount = "mesen_frameskip_max";
 
 uint32_t defaultPalette[0x40] { 0xFF666666, 0xFF002A88, 0xFF1412A7, 0xFF3B00A4, 0xFF5C007E, 0xFF6E0040, 0xFF6C0600, 0xFF561D00, 0xFF333500, 0xFF0B4800, 0xFF005200, 0xFF004F08, 0xFF00404D, 0xFF000000, 0xFF000000, 0xFF000000, 0xFFADADAD, 0xFF155FD9, 0xFF4240FF, 0xFF7527FE, 0xFFA01ACC, 0xFFB71E7B, 0xFFB53120, 0xFF994E00, 0xFF6B6D00, 0xFF388700, 0xFF0C9300, 0xFF008F32, 0xFF007C8D, 0xFF000000, 0xFF000000, 0xFF000000, 0xFFFFFEFF, 0xFF64B0FF, 0xFF9290FF, 0xFFC676FF, 0xFFF36AFF, 0xFFFE6ECC, 0xFFFE8170, 0xFFEA9E22, 0xFFBCBE00, 0xFF88D800, 0xFF5CE430, 0xFF45E082, 0xFF48CDDE, 0xFF4F4F4F, 0xFF000000, 0xFF000000, 0xFFFFFEFF, 0xFFC0DFFF, 0xFFD3D2FF, 0xFFE8C8FF, 0xFFFBC2FF, 0xFFFEC4EA, 0xFFFECCC5, 0xFFF7D8A5, 0xFFE4E594, 0xFFCFEF96, 0xFFBDF4AB, 0xFFB3F3CC, 0xFFB5EBF2, 0xFFB8B8B8, 0xFF000000, 0xFF000000 };
 uint32_t unsaturatedPalette[0x40] { 0xFF6B6B6B, 0xFF001E87, 0xFF1F0B96, 0xFF3B0C87, 0xFF590D61, 0xFF5E0528, 0xFF551100, 0xFF461B00, 0xFF303200, 0xFF0A4800, 0xFF004E00, 0xFF004619, 0xFF003A58, 0xFF000000, 0xFF000000, 0xFF000000, 0xFFB2B2B2, 0xFF1A53D1, 0xFF4835EE, 0xFF7123EC, 0xFF9A1EB7, 0xFFA51E62, 0xFFA52D19, 0xFF874B00, 0xFF676900, 0xFF298400, 0xFF038B00, 0xFF008240, 0xFF007891, 0xFF000000, 0xFF000000, 0xFF000000, 0xFFFFFFFF, 0xFF63ADFD, 0xFF908AFE, 0xFFB977FC, 0xFFE771FE, 0xFFF76FC9, 0xFFF5836A, 0xFFDD9C29, 0xFFBDB807, 0xFF84D107, 0xFF5BDC3B, 0xFF48D77D, 0xFF48CCCE, 0xFF555555, 0xFF000000, 0xFF000000, 0xFFFFFFFF, 0xFFC4E3FE, 0xFFD7D5FE, 0xFFE6CDFE, 0xFFF9CAFE, 0xFFFEC9F0, 0xFFFED1C7, 0xFFF7DCAC, 0xFFE8E89C, 0xFFD1F29D, 0xFFBFF4B1, 0xFFB7F5CD, 0xFFB7F0EE, 0xFFBEBEBE, 0xFF000000, 0xFF000000 };
@@ -100,6 +129,23 @@ extern "C" {
 		}
 	}
 
+	static void RETRO_CALLCONV audio_buffer_status(bool active, unsigned occupancy, bool underrunLikely)
+	{
+		_audioBufferActive = active;
+		_audioBufferOccupancy = occupancy;
+		_audioBufferUnderrunLikely = underrunLikely;
+	}
+
+	//Runs a frame that is never displayed - the video filters (and the HD pack's tile bookkeeping) are skipped entirely
+	static void run_skipped_frame(std::shared_ptr<Console> console)
+	{
+		console->GetVideoRenderer()->SetSkipMode(true);
+		console->GetVideoDecoder()->SetDecodingDisabled(true);
+		console->RunSingleFrame();
+		console->GetVideoDecoder()->SetDecodingDisabled(false);
+		console->GetVideoRenderer()->SetSkipMode(false);
+	}
+
 	RETRO_API unsigned retro_api_version()
 	{
 		return RETRO_API_VERSION;
@@ -136,6 +182,8 @@ extern "C" {
 		_keyManager->SetSupportsInputBitmasks(false);
 		_keyManager.reset();
 		_messageManager.reset();
+		_rewindManager.reset();
+		_runAheadManager.reset();
 
 		_console->SaveBatteries();
 		_console->Release(true);
@@ -160,6 +208,8 @@ extern "C" {
 			{ MesenControllerTurboSpeed, "Controller Turbo Speed; Fast|Very Fast|Disabled|Slow|Normal" },
 			{ MesenShiftButtonsClockwise, u8"Shift A/B/X/Y clockwise; disabled|enabled" },
 			{ MesenHdPacks, "Enable HD Packs; enabled|disabled" },
+			{ MesenHdPackTileCache, "HD Pack tile cache (MB, decodes tiles on demand); disabled|64|128|256|512|1024" },
+			{ MesenHdPackCompile, "Compile HD Packs (hires.bin, faster loading); disabled|enabled" },
 			{ MesenNoSpriteLimit, "Remove sprite limit; disabled|enabled" },
 			{ MesenFakeStereo, u8"Enable fake stereo effect; disabled|enabled" },
 			{ MesenMuteTriangleUltrasonic, u8"Reduce popping on Triangle channel; enabled|disabled" },
@@ -171,6 +221,15 @@ extern "C" {
 			{ MesenFdsAutoSelectDisk, "FDS: Automatically insert disks; disabled|enabled" },
 			{ MesenFdsFastForwardLoad, "FDS: Fast forward while loading; disabled|enabled" },
 			{ MesenAudioSampleRate, "Sound Output Sample Rate; 48000|96000|11025|22050|44100" },
+			{ MesenLazyPpu, "Lazy PPU scheduling (faster, less accurate); disabled|enabled" },
+			{ MesenRewind, "Rewind (hold R3); disabled|enabled" },
+			{ MesenRewindBufferSize, "Rewind buffer size (MB); 32|64|128|256|16" },
+			{ MesenRunAhead, "Run-ahead (reduces input lag, more CPU intensive); disabled|1 frame|2 frames|3 frames" },
+			{ MesenThreadedVideoFilter, "Run video filter on a separate thread (adds 1 frame of lag); disabled|enabled" },
+			{ MesenVideoFilterThreads, "Video filter worker threads; auto|1|2|3|4|6|8" },
+			{ MesenFrameSkip, "Frameskip (skips frames when audio is about to crackle); disabled|auto|threshold" },
+			{ MesenFrameSkipThreshold, "Frameskip threshold (% of audio buffer); 33|20|25|40|50|60|70|80" },
+			{ MesenFrameSkipMaxCount, "Frameskip: max consecutive skipped frames; 3|1|2|4|5|6|8" },
 			{ NULL, NULL },
 		};
 
@@ -252,6 +311,7 @@ extern "C" {
 
 	RETRO_API void retro_set_video_refresh(retro_video_refresh_t sendFrame)
 	{
+		_sendFrame = sendFrame;
 		_console->GetVideoRenderer()->SetVideoCallback(sendFrame);
 	}
 
@@ -352,12 +412,58 @@ extern "C" {
 
 		set_flag(MesenNoSpriteLimit, EmulationFlags::RemoveSpriteLimit | EmulationFlags::AdaptiveSpriteLimit);
 		set_flag(MesenHdPacks, EmulationFlags::UseHdPacks);
+		set_flag(MesenHdPackCompile, EmulationFlags::CompileHdPacks);
 		set_flag(MesenMuteTriangleUltrasonic, EmulationFlags::SilenceTriangleHighFreq);
 		set_flag(MesenReduceDmcPopping, EmulationFlags::ReduceDmcPopping);
 		set_flag(MesenSwapDutyCycle, EmulationFlags::SwapDutyCycles);
 		set_flag(MesenDisableNoiseModeFlag, EmulationFlags::DisableNoiseModeFlag);
 		set_flag(MesenFdsAutoSelectDisk, EmulationFlags::FdsAutoInsertDisk);
 		set_flag(MesenFdsFastForwardLoad, EmulationFlags::FdsFastForwardOnLoad);
+		set_flag(MesenLazyPpu, EmulationFlags::LazyPpuScheduling);
+		set_flag(MesenThreadedVideoFilter, EmulationFlags::ThreadedVideoFilter);
+
+		if(readVariable(MesenHdPackTileCache, var)) {
+			//"disabled" (0) decodes every tile when the pack is loaded
+			_console->GetSettings()->SetHdPackTileCacheSize(std::max(0, atoi(var.value)));
+		}
+
+		if(readVariable(MesenVideoFilterThreads, var)) {
+			//"auto" (0) uses one thread per core
+			_console->GetSettings()->SetVideoFilterThreadCount(std::max(0, atoi(var.value)));
+		}
+
+		FrameSkipMode frameSkipMode = FrameSkipMode::Disabled;
+		if(readVariable(MesenFrameSkip, var)) {
+			string value = string(var.value);
+			if(value == "auto") {
+				frameSkipMode = FrameSkipMode::Auto;
+			} else if(value == "threshold") {
+				frameSkipMode = FrameSkipMode::Threshold;
+			}
+		}
+		if(readVariable(MesenFrameSkipThreshold, var)) {
+			_frameSkipThreshold = std::max(0, atoi(var.value));
+		}
+		if(readVariable(MesenFrameSkipMaxCount, var)) {
+			_frameSkipMaxCount = std::max(1, atoi(var.value));
+		}
+		if(frameSkipMode != _frameSkipMode) {
+			retro_audio_buffer_status_callback callback = { audio_buffer_status };
+			if(!env_cb(RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK, frameSkipMode == FrameSkipMode::Disabled ? nullptr : &callback)) {
+				if(frameSkipMode != FrameSkipMode::Disabled) {
+					logMessage(RETRO_LOG_WARN, "Frameskip is not supported by the frontend.\n");
+				}
+				frameSkipMode = FrameSkipMode::Disabled;
+			}
+
+			if(frameSkipMode != _frameSkipMode) {
+				//The minimum audio latency can only be changed from retro_run
+				_updateAudioLatency = true;
+			}
+			_frameSkipMode = frameSkipMode;
+			_audioBufferActive = false;
+			_skippedFrames = 0;
+		}
 
 		if(readVariable(MesenFakeStereo, var)) {
 			string value = string(var.value);
@@ -569,6 +675,39 @@ extern "C" {
 			}
 		}
 
+		bool rewindEnabled = readVariable(MesenRewind, var) && string(var.value) == "enabled";
+		if(rewindEnabled) {
+			uint32_t bufferSize = 32;
+			if(readVariable(MesenRewindBufferSize, var)) {
+				bufferSize = std::max(1, atoi(var.value));
+			}
+			if(_rewindManager) {
+				_rewindManager->SetMaxMemoryUsage(bufferSize * 1024 * 1024);
+			} else {
+				_rewindManager.reset(new RewindManager(_console, bufferSize * 1024 * 1024));
+			}
+		} else {
+			_rewindManager.reset();
+		}
+
+		uint32_t runAheadFrames = 0;
+		if(readVariable(MesenRunAhead, var)) {
+			runAheadFrames = std::max(0, atoi(var.value));
+		}
+		if(runAheadFrames > 0) {
+			if(_runAheadManager) {
+				_runAheadManager->SetFrameCount(runAheadFrames);
+			} else {
+				_runAheadManager.reset(new RunAheadManager(_console, runAheadFrames));
+				if(_loadedRom.IsValid()) {
+					//Enabled while a game is running
+					_runAheadManager->LoadGame(_loadedRom, env_cb, _sendFrame);
+				}
+			}
+		} else {
+			_runAheadManager.reset();
+		}
+
 		auto getKeyCode = [=](int port, int retroKey) {
 			return (port << 8) | (retroKey + 1);
 		};
@@ -669,29 +808,97 @@ extern "C" {
 	{
 		if(_console->GetSettings()->CheckFlag(EmulationFlags::ForceMaxSpeed)) {
 			//Skip frames to speed up emulation while still outputting at 50/60 fps (needed for FDS fast forward while loading)
-			_console->GetVideoRenderer()->SetSkipMode(true);
 			_console->GetSoundMixer()->SetSkipMode(true);
 			for(int i = 0; i < 9; i++) {
 				//Attempt to speed up to 1000% speed
-				_console->RunSingleFrame();
+				run_skipped_frame(_console);
 			}
-			_console->GetVideoRenderer()->SetSkipMode(false);
 			_console->GetSoundMixer()->SetSkipMode(false);
 		}
 
 		bool updated = false;
 		if(env_cb(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &updated) && updated) {
+			//The video filters read the settings, don't change them while a frame is being filtered on another thread
+			_console->GetVideoDecoder()->WaitForDecode();
+			std::shared_ptr<Console> runAheadConsole = _runAheadManager ? _runAheadManager->GetRunAheadConsole() : nullptr;
+			if(runAheadConsole) {
+				runAheadConsole->GetVideoDecoder()->WaitForDecode();
+			}
 			update_settings();
 
+			//The same PPU output can produce a different picture with the new settings (palette, overscan, etc.)
+			_console->GetVideoDecoder()->InvalidateLastFrame();
+			if(runAheadConsole) {
+				runAheadConsole->GetVideoDecoder()->InvalidateLastFrame();
+			}
+
 			bool hdPacksEnabled = _console->GetSettings()->CheckFlag(EmulationFlags::UseHdPacks);
 			if(hdPacksEnabled != _hdPacksEnabled) {
 				//Try to load/unload HD pack when the flag is toggled
 				_console->UpdateHdPackMode();
+				if(_runAheadManager) {
+					_runAheadManager->UpdateHdPackMode();
+				}
 				_hdPacksEnabled = hdPacksEnabled;
 			}
 		}
 
-		_console->RunSingleFrame();
+		//Rewind by one frame while the button is held - the restored frame is run again (without sound) to display it
+		bool rewinding = _rewindManager && _keyManager->IsKeyPressed(RETRO_DEVICE_ID_JOYPAD_R3 + 1);
+		if(rewinding) {
+			_rewindManager->StepBack();
+			_console->GetSoundMixer()->SetSkipMode(true);
+		}
+
+		if(_updateAudioLatency) {
+			//Frameskip works best with a larger audio buffer (6 frames), 0 restores the frontend's default
+			unsigned audioLatency = 0;
+			if(_frameSkipMode != FrameSkipMode::Disabled) {
+				retro_system_av_info avInfo = {};
+				_console->GetVideoRenderer()->GetSystemAudioVideoInfo(avInfo);
+				audioLatency = (unsigned)(6 * 1000 / avInfo.timing.fps + 0.5);
+			}
+			env_cb(RETRO_ENVIRONMENT_SET_MINIMUM_AUDIO_LATENCY, &audioLatency);
+			_updateAudioLatency = false;
+		}
+
+		bool skipFrame = false;
+		if(_frameSkipMode != FrameSkipMode::Disabled && _audioBufferActive && !rewinding) {
+			bool underrunLikely = _frameSkipMode == FrameSkipMode::Auto ? _audioBufferUnderrunLikely : _audioBufferOccupancy < _frameSkipThreshold;
+			if(underrunLikely && _skippedFrames < _frameSkipMaxCount) {
+				skipFrame = true;
+				_skippedFrames++;
+			} else {
+				_skippedFrames = 0;
+			}
+		}
+
+		if(skipFrame) {
+			//Run-ahead is skipped too, the run-ahead console is synced with the main console again on the next frame
+			run_skipped_frame(_console);
+
+			//Let the frontend know it can keep showing the previous frame
+			std::shared_ptr<Console> runAheadConsole = _runAheadManager ? _runAheadManager->GetRunAheadConsole() : nullptr;
+			for(std::shared_ptr<Console> console : { _console, runAheadConsole }) {
+				if(console && console->GetVideoRenderer()->CanSendDuplicateFrame()) {
+					console->GetVideoRenderer()->SendDuplicateFrame();
+					break;
+				}
+			}
+		} else if(_runAheadManager && !rewinding) {
+			//The frontend can write to the work/save RAM through the pointers given by retro_set_memory_maps/retro_get_memory_data (cheats, achievements)
+			//These writes are not tracked, the pages must be copied to the run-ahead console on the next sync
+			_console->GetMapper()->MarkPrgRamModified();
+			_runAheadManager->RunFrame();
+		} else {
+			_console->RunSingleFrame();
+		}
+
+		if(rewinding) {
+			_console->GetSoundMixer()->SetSkipMode(false);
+		} else if(_rewindManager) {
+			_rewindManager->RecordState();
+		}
 
 		if(updated) {
 			//Update geometry after running the frame, in case the console's region changed (affects "auto" aspect ratio)
@@ -710,22 +917,20 @@ extern "C" {
 
 	RETRO_API bool retro_serialize(void *data, size_t size)
 	{
-		std::stringstream ss;
-		_console->GetSaveStateManager()->SaveState(ss);
-		
-		string saveStateData = ss.str();
-		memset(data, 0, size);
-		memcpy(data, saveStateData.c_str(), std::min(size, saveStateData.size()));
+		uint32_t stateSize = 0;
+		if(!_console->GetSaveStateManager()->SaveState((uint8_t*)data, (uint32_t)size, stateSize)) {
+			return false;
+		}
+
+		//Clear the unused part of the buffer, to keep the data identical for identical states
+		memset((uint8_t*)data + stateSize, 0, size - stateSize);
 
 		return true;
 	}
 
 	RETRO_API bool retro_unserialize(const void *data, size_t size)
 	{
-		std::stringstream ss;
-		ss.write((char*)data, size);
-
-		bool result = _console->GetSaveStateManager()->LoadState(ss, false);
+		bool result = _console->GetSaveStateManager()->LoadState((uint8_t*)data, (uint32_t)size, false);
 		if(result)
 			_console->GetSettings()->SetSampleRate(_audioSampleRate);
 		return result;
@@ -734,9 +939,12 @@ extern "C" {
 	RETRO_API void retro_cheat_reset()
 	{
 		_console->GetCheatManager()->ClearCodes();
+		if(_runAheadManager) {
+			_runAheadManager->SyncCheats();
+		}
 	}
 
-	RETRO_API void retro_cheat_set(unsigned index, bool enabled, const char *codeStr)
+	void add_cheat_code(const char *codeStr)
 	{
 		static const string validGgLetters = "APZLGITYEOXUKSVN";
 		static const string validParLetters = "0123456789ABCDEF";
@@ -828,6 +1036,14 @@ extern "C" {
 
 	}
 
+	RETRO_API void retro_cheat_set(unsigned index, bool enabled, const char *codeStr)
+	{
+		add_cheat_code(codeStr);
+		if(_runAheadManager) {
+			_runAheadManager->SyncCheats();
+		}
+	}
+
 	void update_input_descriptors()
 	{
 		vector<retro_input_descriptor> desc;
@@ -902,6 +1118,9 @@ extern "C" {
 						addDesc(port, RETRO_DEVICE_ID_JOYPAD_L2, "(VS) Insert Coin 1");
 						addDesc(port, RETRO_DEVICE_ID_JOYPAD_R2, "(VS) Insert Coin 2");
 						addDesc(port, RETRO_DEVICE_ID_JOYPAD_L3, "(Famicom) Microphone (P2)");
+						if(_rewindManager) {
+							addDesc(port, RETRO_DEVICE_ID_JOYPAD_R3, "Rewind");
+						}
 					}
 				}
 				addDesc(port, RETRO_DEVICE_ID_JOYPAD_START, "Start");
@@ -1134,6 +1353,9 @@ extern "C" {
 
 		// Load content
 		VirtualFile romData(gameData, gameSize, gamePath);
+
+		//Keep an unmodified copy of the rom, the run-ahead console may need to load it later on
+		_loadedRom = romData;
 		bool result = _console->Initialize(romData);
 
 		if(result) {
@@ -1150,12 +1372,20 @@ extern "C" {
 			//Savestates in Mesen may change size over time
 			//Retroarch doesn't like this for netplay or rewinding - it requires the states to always be the exact same size
 			//So we need to send a large enough size to Retroarch to ensure Mesen's state will always fit within that buffer.
-			std::stringstream ss;
-			_console->GetSaveStateManager()->SaveState(ss);
+			uint32_t stateSize = _console->GetSaveStateManager()->GetStateSize();
 
 			//Round up to the next 1kb multiple
-			_saveStateSize = ((ss.str().size() * 2) + 0x400) & ~0x3FF;
+			_saveStateSize = ((stateSize * 2) + 0x400) & ~0x3FF;
 			retro_set_memory_maps();
+
+			if(_rewindManager) {
+				_rewindManager->Reset();
+			}
+			if(_runAheadManager) {
+				_runAheadManager->LoadGame(_loadedRom, env_cb, _sendFrame);
+			}
+		} else {
+			_loadedRom = VirtualFile();
 		}
 
 		return result;
@@ -1168,6 +1398,13 @@ extern "C" {
 
 	RETRO_API void retro_unload_game()
 	{
+		if(_rewindManager) {
+			_rewindManager->Reset();
+		}
+		if(_runAheadManager) {
+			_runAheadManager->UnloadGame();
+		}
+		_loadedRom = VirtualFile();
 	}
 
 	RETRO_API unsigned retro_get_region()
@@ -46,12 +46,15 @@
 void HQX_CALLCONV hqxInit(void);
 void HQX_CALLCONV hqx(uint32_t scale, uint32_t * src, uint32_t * dest, int width, int height);
 
+//Only processes source rows [yFirst, yLast) - slices of the same image can be scaled by multiple threads as long as they do not overlap
+void HQX_CALLCONV hqx_slice(uint32_t scale, uint32_t * src, uint32_t * dest, int width, int height, int yFirst, int yLast);
+
 void HQX_CALLCONV hq2x_32( uint32_t * src, uint32_t * dest, int width, int height );
 void HQX_CALLCONV hq3x_32( uint32_t * src, uint32_t * dest, int width, int height );
 void HQX_CALLCONV hq4x_32( uint32_t * src, uint32_t * dest, int width, int height );
 
-void HQX_CALLCONV hq2x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
-void HQX_CALLCONV hq3x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
-void HQX_CALLCONV hq4x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
+void HQX_CALLCONV hq2x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int yFirst, int yLast );
+void HQX_CALLCONV hq3x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int yFirst, int yLast );
+void HQX_CALLCONV hq4x_32_rb( uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int yFirst, int yLast );
 
 #endif
@@ -45,4 +45,13 @@ void HQX_CALLCONV hqx(uint32_t scale, uint32_t * src, uint32_t * dest, int width
 		case 3: hq3x_32(src, dest, width, height); break;
 		case 4: hq4x_32(src, dest, width, height); break;
 	}
-}
\ No newline at end of file
+}
+void HQX_CALLCONV hqx_slice(uint32_t scale, uint32_t * src, uint32_t * dest, int width, int height, int yFirst, int yLast)
+{
+	uint32_t rowBytes = width * 4;
+	switch(scale) {
+		case 2: hq2x_32_rb(src, rowBytes, dest, rowBytes * 2, width, height, yFirst, yLast); break;
+		case 3: hq3x_32_rb(src, rowBytes, dest, rowBytes * 3, width, height, yFirst, yLast); break;
+		case 4: hq4x_32_rb(src, rowBytes, dest, rowBytes * 4, width, height, yFirst, yLast); break;
+	}
+}
@@ -0,0 +1,131 @@
+#include "stdafx.h"
+#include "MemoryMappedFile.h"
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#define MAPPED_FILE_MMAP
+#endif
+
+MemoryMappedFile::MemoryMappedFile()
+{
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+	Close();
+}
+
+bool MemoryMappedFile::Open(string filename)
+{
+	Close();
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileW(utf8::utf8::decode(filename).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	_fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		Close();
+		return false;
+	}
+
+	_mappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(!_mappingHandle) {
+		Close();
+		return false;
+	}
+
+	_data = (uint8_t*)MapViewOfFile(_mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if(!_data) {
+		Close();
+		return false;
+	}
+	_size = (size_t)fileSize.QuadPart;
+	return true;
+#elif defined(MAPPED_FILE_MMAP)
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd < 0) {
+		return false;
+	}
+
+	struct stat fileInfo;
+	if(fstat(fd, &fileInfo) != 0 || fileInfo.st_size == 0) {
+		close(fd);
+		return false;
+	}
+
+	//The mapping stays valid once the file descriptor is closed
+	void* data = mmap(nullptr, (size_t)fileInfo.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED) {
+		return false;
+	}
+
+	_data = (uint8_t*)data;
+	_size = (size_t)fileInfo.st_size;
+	return true;
+#else
+	ifstream file(filename, std::ios::in | std::ios::binary);
+	if(!file) {
+		return false;
+	}
+
+	file.seekg(0, std::ios::end);
+	_buffer.resize((size_t)file.tellg());
+	file.seekg(0, std::ios::beg);
+	file.read((char*)_buffer.data(), _buffer.size());
+	if(!file || _buffer.empty()) {
+		_buffer.clear();
+		return false;
+	}
+
+	_data = _buffer.data();
+	_size = _buffer.size();
+	return true;
+#endif
+}
+
+void MemoryMappedFile::Close()
+{
+#if defined(_WIN32)
+	if(_data) {
+		UnmapViewOfFile(_data);
+	}
+	if(_mappingHandle) {
+		CloseHandle(_mappingHandle);
+		_mappingHandle = nullptr;
+	}
+	if(_fileHandle) {
+		CloseHandle(_fileHandle);
+		_fileHandle = nullptr;
+	}
+#elif defined(MAPPED_FILE_MMAP)
+	if(_data) {
+		munmap(_data, _size);
+	}
+#else
+	_buffer.clear();
+#endif
+
+	_data = nullptr;
+	_size = 0;
+}
+
+uint8_t* MemoryMappedFile::GetData()
+{
+	return _data;
+}
+
+size_t MemoryMappedFile::GetSize()
+{
+	return _size;
+}
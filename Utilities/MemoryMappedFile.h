@@ -0,0 +1,31 @@
+#pragma once
+#include "stdafx.h"
+
+//Read-only view of a whole file, memory-mapped when the platform supports it (otherwise the file is read into memory)
+//Mapped pages are shared through the OS' page cache, so multiple processes using the same file only load it once
+class MemoryMappedFile
+{
+private:
+	uint8_t* _data = nullptr;
+	size_t _size = 0;
+	vector<uint8_t> _buffer;
+
+#ifdef _WIN32
+	void* _fileHandle = nullptr;
+	void* _mappingHandle = nullptr;
+#endif
+
+	void Close();
+
+public:
+	MemoryMappedFile();
+	~MemoryMappedFile();
+
+	MemoryMappedFile(const MemoryMappedFile&) = delete;
+	MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+	bool Open(string filename);
+
+	uint8_t* GetData();
+	size_t GetSize();
+};
@@ -471,3 +471,62 @@ void scale(unsigned scale, void* void_dst, unsigned dst_slice, const void* void_
 	}
 }
 
+
+/**
+ * Apply the Scale effect on a horizontal slice of a bitmap.
+ * Only the destination rows that match the source rows [first, last) are written, so
+ * multiple threads can process different slices of the same bitmap at the same time.
+ * \param scale Scale factor. 2, 3 or 4.
+ * \param void_dst Pointer at the first pixel of the destination bitmap (not of the slice).
+ * \param void_src Pointer at the first pixel of the source bitmap (not of the slice).
+ * \param first First source row of the slice.
+ * \param last Source row following the last row of the slice.
+ */
+void scale_slice(unsigned scale, void* void_dst, unsigned dst_slice, const void* void_src, unsigned src_slice, unsigned pixel, unsigned width, unsigned height, unsigned first, unsigned last)
+{
+	unsigned char* dst = (unsigned char*)void_dst;
+	const unsigned char* src = (const unsigned char*)void_src;
+
+	auto srcRow = [=](int row) {
+		row = row < 0 ? 0 : (row >= (int)height ? height - 1 : row);
+		return src + row * src_slice;
+	};
+
+	switch (scale) {
+	case 2 :
+		for (unsigned y = first; y < last; y++) {
+			stage_scale2x(dst + (y * 2) * dst_slice, dst + (y * 2 + 1) * dst_slice, srcRow(y - 1), srcRow(y), srcRow(y + 1), pixel, width);
+		}
+		break;
+	case 3 :
+		for (unsigned y = first; y < last; y++) {
+			stage_scale3x(dst + (y * 3) * dst_slice, dst + (y * 3 + 1) * dst_slice, dst + (y * 3 + 2) * dst_slice, srcRow(y - 1), srcRow(y), srcRow(y + 1), pixel, width);
+		}
+		break;
+	case 4 : {
+		//Scale4x is Scale2x applied twice - the intermediate (2x) rows needed by the slice
+		//are the ones generated by the slice's own rows plus one source row above and below it
+		unsigned mid_slice = 2 * pixel * width;
+		int midFirst = ((int)first - 1) * 2;
+		unsigned char* mid = (unsigned char*)malloc(((last - first) * 2 + 4) * mid_slice);
+		if (!mid)
+			return;
+
+		auto midRow = [=](int row) {
+			row = row < 0 ? 0 : (row >= (int)height * 2 ? height * 2 - 1 : row);
+			return mid + (row - midFirst) * mid_slice;
+		};
+
+		for (int y = (first > 0 ? first - 1 : 0); y <= (int)last && y < (int)height; y++) {
+			unsigned char* row0 = mid + (y * 2 - midFirst) * mid_slice;
+			stage_scale2x(row0, row0 + mid_slice, srcRow(y - 1), srcRow(y), srcRow(y + 1), pixel, width);
+		}
+
+		for (unsigned y = first * 2; y < last * 2; y += 2) {
+			stage_scale4x(dst + (y * 2) * dst_slice, dst + (y * 2 + 1) * dst_slice, dst + (y * 2 + 2) * dst_slice, dst + (y * 2 + 3) * dst_slice, midRow(y - 1), midRow(y), midRow(y + 1), midRow(y + 2), pixel, width);
+		}
+		free(mid);
+		break;
+	}
+	}
+}
@@ -0,0 +1,96 @@
+#include "stdafx.h"
+#include <algorithm>
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	_nextTask = 0;
+	if(threadCount == 0) {
+		threadCount = GetDefaultThreadCount();
+	}
+
+	for(uint32_t i = 1; i < threadCount; i++) {
+		_threads.push_back(std::thread(&ThreadPool::WorkerThread, this));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_startSignal.notify_all();
+
+	for(std::thread &thread : _threads) {
+		thread.join();
+	}
+}
+
+uint32_t ThreadPool::GetDefaultThreadCount()
+{
+	return std::max(1u, std::thread::hardware_concurrency());
+}
+
+uint32_t ThreadPool::GetThreadCount()
+{
+	return (uint32_t)_threads.size() + 1;
+}
+
+void ThreadPool::ProcessTasks()
+{
+	uint32_t taskIndex;
+	while((taskIndex = _nextTask++) < _taskCount) {
+		(*_task)(taskIndex);
+	}
+}
+
+void ThreadPool::WorkerThread()
+{
+	uint64_t lastJobId = 0;
+	while(true) {
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_startSignal.wait(lock, [&] { return _stop || _jobId != lastJobId; });
+			if(_stop) {
+				return;
+			}
+			lastJobId = _jobId;
+		}
+
+		ProcessTasks();
+
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_activeWorkers--;
+		}
+		_doneSignal.notify_one();
+	}
+}
+
+void ThreadPool::Run(uint32_t taskCount, const std::function<void(uint32_t)> &task)
+{
+	if(_threads.empty() || taskCount <= 1) {
+		for(uint32_t i = 0; i < taskCount; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_task = &task;
+		_taskCount = taskCount;
+		_nextTask = 0;
+		_activeWorkers = (uint32_t)_threads.size();
+		_jobId++;
+	}
+	_startSignal.notify_all();
+
+	ProcessTasks();
+
+	//Wait for the workers to be done with their last task (and to stop using _task)
+	std::unique_lock<std::mutex> lock(_mutex);
+	_doneSignal.wait(lock, [&] { return _activeWorkers == 0; });
+	_task = nullptr;
+}
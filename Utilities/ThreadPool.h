@@ -0,0 +1,38 @@
+#pragma once
+#include "stdafx.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+//Persistent set of worker threads used to split a job (e.g a video filter) into independent parts
+//The calling thread also processes parts, so a pool with a thread count of 1 runs everything on the caller's thread
+class ThreadPool
+{
+private:
+	vector<std::thread> _threads;
+	std::mutex _mutex;
+	std::condition_variable _startSignal;
+	std::condition_variable _doneSignal;
+
+	const std::function<void(uint32_t)>* _task = nullptr;
+	uint32_t _taskCount = 0;
+	atomic<uint32_t> _nextTask;
+	uint32_t _activeWorkers = 0;
+	uint64_t _jobId = 0;
+	bool _stop = false;
+
+	void WorkerThread();
+	void ProcessTasks();
+
+public:
+	//threadCount includes the calling thread, 0 uses one thread per core
+	ThreadPool(uint32_t threadCount);
+	~ThreadPool();
+
+	static uint32_t GetDefaultThreadCount();
+	uint32_t GetThreadCount();
+
+	//Calls task(0) to task(taskCount - 1), spread over all threads - returns once all of them are done
+	void Run(uint32_t taskCount, const std::function<void(uint32_t)> &task);
+};